@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "batch.hpp"
+
+//
+// Compares lockstep Batch engines against the same number of independent scalar Cpus.
+// Usage: bench_batch [instances] [frames] [rom_file]
+// Without a ROM file a built-in ALU and random sprite loop is used.
+//
+
+using chip8_emu::Batch;
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+static constexpr uint32_t kInstructionsPerFrame = 100;
+
+static const std::vector<uint8_t> kBuiltinRom = {
+    0xC0, 0x3F, // 0x200: V0 = rand & 0x3F
+    0x61, 0x11, // 0x202: V1 = 0x11
+    0x80, 0x14, // 0x204: V0 += V1
+    0x81, 0x05, // 0x206: V1 -= V0
+    0x82, 0x13, // 0x208: V2 ^= V1
+    0x83, 0x06, // 0x20A: V3 = V0 >> 1
+    0x73, 0x07, // 0x20C: V3 += 7
+    0x84, 0x3E, // 0x20E: V4 = V3 << 1
+    0x34, 0x00, // 0x210: skip if V4 == 0
+    0x75, 0x01, // 0x212: V5 += 1
+    0x12, 0x04, // 0x214: jump 0x204
+};
+
+struct RunResult {
+    double seconds;
+    uint64_t executed;
+    std::vector<uint64_t> hashes;
+};
+
+static std::vector<uint8_t> load_rom(const char* path) {
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io) {
+        throw std::runtime_error{ std::string("Could not open ") + path };
+    }
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> rom(size);
+    io.read(reinterpret_cast<char*>(rom.data()), size);
+    return rom;
+}
+
+static RunResult run_scalar(const std::vector<uint8_t>& rom, const size_t instances, const uint64_t frames) {
+    RunResult result{ 0, 0, {} };
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < instances; i++) {
+        Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+        cpu.Seed(static_cast<uint32_t>(i + 1));
+        cpu.Load(rom);
+        for (uint64_t frame = 0; frame < frames && !cpu.IsTrapped() && !cpu.GetMemory().HasFault(); frame++) {
+            result.executed += cpu.RunFrame(kInstructionsPerFrame);
+        }
+        result.hashes.push_back(cpu.GetFramebuffer().Hash());
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+template <size_t kLanes>
+static RunResult run_batches(const std::vector<uint8_t>& rom, const size_t instances, const uint64_t frames, double& lockstep) {
+    RunResult result{ 0, 0, {} };
+    uint64_t lockstep_steps = 0;
+    uint64_t steps = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < instances; first += kLanes) {
+        std::vector<uint32_t> seeds;
+        for (size_t i = first; i < instances && i < first + kLanes; i++) {
+            seeds.push_back(static_cast<uint32_t>(i + 1));
+        }
+
+        auto batch = std::make_unique<Batch<kLanes>>(rom, seeds);
+        for (const auto& lane : batch->Run(frames, kInstructionsPerFrame)) {
+            result.executed += lane.instructions;
+            result.hashes.push_back(lane.framebuffer_hash);
+        }
+        lockstep_steps += batch->GetLockstepSteps();
+        steps += batch->GetLockstepSteps() + batch->GetDivergentSteps();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    lockstep = steps ? 100.0 * lockstep_steps / steps : 0;
+    return result;
+}
+
+template <size_t kLanes>
+static bool report(const std::vector<uint8_t>& rom, const size_t instances, const uint64_t frames, const RunResult& scalar) {
+    double lockstep = 0;
+    const auto batch = run_batches<kLanes>(rom, instances, frames, lockstep);
+    const auto mips = batch.executed / batch.seconds / 1e6;
+
+    std::cout << "  batch<" << kLanes << ">: " << mips << " MIPS, "
+        << mips / (scalar.executed / scalar.seconds / 1e6) << "x, " << lockstep << "% lockstep steps\n";
+
+    if (batch.hashes != scalar.hashes || batch.executed != scalar.executed) {
+        std::cerr << "  batch<" << kLanes << "> diverged from the scalar cores!\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const size_t instances = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 256;
+        const uint64_t frames = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : 600;
+        const auto rom = argc > 3 ? load_rom(argv[3]) : kBuiltinRom;
+
+        const auto scalar = run_scalar(rom, instances, frames);
+        std::cout << instances << " instances, " << frames << " frames\n";
+        std::cout << "  scalar:    " << scalar.executed / scalar.seconds / 1e6 << " MIPS\n";
+
+        bool same = true;
+        same &= report<8>(rom, instances, frames, scalar);
+        same &= report<16>(rom, instances, frames, scalar);
+        same &= report<32>(rom, instances, frames, scalar);
+        return same ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cpu.hpp"
+
+//
+// Compares the handler table core against the threaded and JIT cores.
+// Usage: bench_cores [instructions] [rom_file...]
+// Without ROM files a built-in ALU/branch/call loop is used.
+//
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+struct CoreResult {
+    double seconds;
+    uint64_t executed;
+    chip8_emu::Registers registers;
+};
+
+static const std::vector<uint8_t> kBuiltinRom = {
+    0x60, 0x00, // 0x200: V0 = 0
+    0x61, 0x01, // 0x202: V1 = 1
+    0x80, 0x14, // 0x204: V0 += V1
+    0x72, 0x01, // 0x206: V2 += 1
+    0x32, 0x00, // 0x208: skip if V2 == 0
+    0x12, 0x04, // 0x20A: jump 0x204
+    0x22, 0x10, // 0x20C: call 0x210
+    0x12, 0x04, // 0x20E: jump 0x204
+    0x83, 0x24, // 0x210: V3 += V2
+    0xA3, 0x00, // 0x212: I = 0x300
+    0xF3, 0x1E, // 0x214: I += V3
+    0x00, 0xEE, // 0x216: return
+};
+
+static std::vector<uint8_t> load_rom(const char* path) {
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io) {
+        throw std::runtime_error{ std::string("Could not open ") + path };
+    }
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> rom(size);
+    io.read(reinterpret_cast<char*>(rom.data()), size);
+    return rom;
+}
+
+static CoreResult run_core(const CpuCore core, const std::vector<uint8_t>& rom, const uint64_t instructions) {
+    Cpu<> cpu(core, Frontend::kHeadless);
+    cpu.Load(rom);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto executed = cpu.Execute(instructions);
+    const auto end = std::chrono::steady_clock::now();
+
+    return { std::chrono::duration<double>(end - start).count(), executed, cpu.GetRegisters() };
+}
+
+static bool bench_rom(const std::string& name, const std::vector<uint8_t>& rom, const uint64_t instructions) {
+    const auto table = run_core(CpuCore::kHandlerTable, rom, instructions);
+    const auto threaded = run_core(CpuCore::kThreaded, rom, instructions);
+    const auto jit = run_core(CpuCore::kJit, rom, instructions);
+
+    std::cout << name << "\n";
+    std::cout << "  handler table: " << table.executed / table.seconds / 1e6 << " MIPS\n";
+    std::cout << "  threaded:      " << threaded.executed / threaded.seconds / 1e6 << " MIPS\n";
+    std::cout << "  jit:           " << jit.executed / jit.seconds / 1e6 << " MIPS\n";
+
+    bool same = true;
+    for (const auto& other : { threaded, jit }) {
+        if (table.executed != other.executed ||
+            std::memcmp(&table.registers, &other.registers, sizeof(table.registers)) != 0) {
+            same = false;
+        }
+    }
+    if (!same) {
+        std::cerr << "  cores diverged!\n";
+    }
+    return same;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint64_t instructions = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 100'000'000ULL;
+
+        bool same = true;
+        if (argc > 2) {
+            for (int i = 2; i < argc; i++) {
+                same &= bench_rom(argv[i], load_rom(argv[i]), instructions);
+            }
+        } else {
+            same &= bench_rom("builtin", kBuiltinRom, instructions);
+        }
+        return same ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "farm.hpp"
+
+//
+// Measures how Farm throughput scales with the number of worker threads.
+// Usage: bench_farm [instances] [frames] [rom_file]
+// Without a ROM file a built-in random sprite loop is used.
+//
+
+using chip8_emu::CpuCore;
+using chip8_emu::Farm;
+
+static const std::vector<uint8_t> kBuiltinRom = {
+    0xC0, 0x3F, // 0x200: V0 = rand & 0x3F
+    0xC1, 0x1F, // 0x202: V1 = rand & 0x1F
+    0xA0, 0x00, // 0x204: I = sprite for 0
+    0xD0, 0x15, // 0x206: draw at V0, V1
+    0x80, 0x14, // 0x208: V0 += V1
+    0x72, 0x01, // 0x20A: V2 += 1
+    0x12, 0x00, // 0x20C: jump 0x200
+};
+
+static std::vector<uint8_t> load_rom(const char* path) {
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io) {
+        throw std::runtime_error{ std::string("Could not open ") + path };
+    }
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> rom(size);
+    io.read(reinterpret_cast<char*>(rom.data()), size);
+    return rom;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const size_t instances = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 4096;
+        const uint64_t frames = argc > 2 ? std::strtoull(argv[2], nullptr, 0) : 600;
+        const auto rom = argc > 3 ? load_rom(argv[3]) : kBuiltinRom;
+
+        std::vector<uint32_t> seeds(instances);
+        std::iota(seeds.begin(), seeds.end(), 1);
+
+        //
+        // Powers of two up to the core count, plus the core count itself.
+        //
+        const size_t cores = std::max(1U, std::thread::hardware_concurrency());
+        std::vector<size_t> thread_counts;
+        for (size_t threads = 1; threads < cores; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(cores);
+
+        double single_thread_mips = 0;
+        for (const auto threads : thread_counts) {
+            Farm farm(rom, seeds, CpuCore::kHandlerTable, 100, threads);
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto& results = farm.Run(frames);
+            const auto end = std::chrono::steady_clock::now();
+
+            uint64_t executed = 0;
+            for (const auto& result : results) {
+                executed += result.instructions;
+            }
+
+            const auto mips = executed / std::chrono::duration<double>(end - start).count() / 1e6;
+            if (threads == 1) {
+                single_thread_mips = mips;
+            }
+            std::cout << threads << " threads: " << mips << " MIPS, " << mips / single_thread_mips << "x\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,153 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cpu.hpp"
+
+//
+// Host time per emulated second with idle loop skipping off and on.
+// Checks both runs end in the same state.
+// Usage: bench_idle [seconds] [instructions_per_frame] [rom_file...]
+//
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+//
+// A frame locked game loop: draw, then wait for the delay timer.
+//
+static const std::vector<uint8_t> kDelayWaitRom = {
+    0x60, 0x01, // 0x200: V0 = 1
+    0xF0, 0x15, // 0x202: DT = V0
+    0xA2, 0x20, // 0x204: I = sprite
+    0xD1, 0x25, // 0x206: draw at V1, V2
+    0x71, 0x03, // 0x208: V1 += 3
+    0x72, 0x01, // 0x20A: V2 += 1
+    0xD1, 0x25, // 0x20C: draw at V1, V2
+    0xF3, 0x07, // 0x20E: V3 = DT
+    0x33, 0x00, // 0x210: skip if V3 == 0
+    0x12, 0x0E, // 0x212: jump 0x20E
+    0x12, 0x02, // 0x214: jump 0x202
+    0x00, 0x00,
+    0x00, 0x00,
+    0x00, 0x00,
+    0x00, 0x00,
+    0x00, 0x00,
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0x220: sprite
+};
+
+//
+// A title screen polling for a key that's never pressed.
+//
+static const std::vector<uint8_t> kKeyWaitRom = {
+    0x60, 0x05, // 0x200: V0 = 5
+    0xE0, 0xA1, // 0x202: skip if key V0 not pressed
+    0x12, 0x08, // 0x204: jump 0x208
+    0x12, 0x02, // 0x206: jump 0x202
+    0x12, 0x08, // 0x208: jump 0x208
+};
+
+//
+// Never idle: what probing short backward jumps costs.
+//
+static const std::vector<uint8_t> kBusyRom = {
+    0x60, 0x00, // 0x200: V0 = 0
+    0x61, 0x01, // 0x202: V1 = 1
+    0x80, 0x14, // 0x204: V0 += V1
+    0x72, 0x01, // 0x206: V2 += 1
+    0x32, 0x00, // 0x208: skip if V2 == 0
+    0x12, 0x04, // 0x20A: jump 0x204
+    0x12, 0x00, // 0x20C: jump 0x200
+};
+
+static std::vector<uint8_t> load_rom(const char* path) {
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io) {
+        throw std::runtime_error(std::string("Could not open ") + path);
+    }
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+    std::vector<uint8_t> rom(size);
+    io.read(reinterpret_cast<char*>(rom.data()), size);
+    return rom;
+}
+
+struct IdleResult {
+    double ms_per_second = 0;
+    uint64_t executed = 0;
+    uint64_t hash = 0;
+    chip8_emu::Registers registers{};
+};
+
+//
+// Best of a few runs, the host is the noisy part.
+//
+static IdleResult run(const CpuCore core, const bool is_skipping, const std::vector<uint8_t>& rom, const uint64_t seconds, const uint32_t instructions_per_frame) {
+    IdleResult result;
+    for (int repetition = 0; repetition < 3; repetition++) {
+        Cpu<> cpu(core, Frontend::kHeadless);
+        cpu.SetIdleLoopSkipping(is_skipping);
+        cpu.Load(rom);
+
+        uint64_t executed = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t frame = 0; frame < seconds * chip8_emu::kTimerFrequency && !cpu.IsTrapped() && !cpu.GetMemory().HasFault(); frame++) {
+            executed += cpu.RunFrame(instructions_per_frame);
+        }
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (repetition == 0 || ms / seconds < result.ms_per_second) {
+            result.ms_per_second = ms / seconds;
+        }
+        result.executed = executed;
+        result.hash = cpu.GetFramebuffer().Hash();
+        result.registers = cpu.GetRegisters();
+    }
+    return result;
+}
+
+static bool bench_rom(const std::string& name, const std::vector<uint8_t>& rom, const uint64_t seconds, const uint32_t instructions_per_frame) {
+    bool same = true;
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded }) {
+        const auto interpreted = run(core, false, rom, seconds, instructions_per_frame);
+        const auto skipped = run(core, true, rom, seconds, instructions_per_frame);
+
+        const bool is_same = interpreted.executed == skipped.executed && interpreted.hash == skipped.hash &&
+            std::memcmp(&interpreted.registers, &skipped.registers, sizeof(interpreted.registers)) == 0;
+        same &= is_same;
+
+        std::cout << name << ", " << (core == CpuCore::kHandlerTable ? "table" : "threaded") << ": "
+                  << interpreted.ms_per_second << " ms per emulated second interpreted, "
+                  << skipped.ms_per_second << " ms skipping idle loops, "
+                  << 100.0 * (1.0 - skipped.ms_per_second / interpreted.ms_per_second) << "% saved"
+                  << (is_same ? "" : " MISMATCH") << "\n";
+    }
+    return same;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint64_t seconds = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 60;
+        const uint32_t instructions_per_frame = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 0)) : 1000;
+
+        bool same = true;
+        if (argc > 3) {
+            for (int i = 3; i < argc; i++) {
+                same &= bench_rom(argv[i], load_rom(argv[i]), seconds, instructions_per_frame);
+            }
+        } else {
+            same &= bench_rom("delay wait", kDelayWaitRom, seconds, instructions_per_frame);
+            same &= bench_rom("key wait", kKeyWaitRom, seconds, instructions_per_frame);
+            same &= bench_rom("busy", kBusyRom, seconds, instructions_per_frame);
+        }
+        return same ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "cpu.hpp"
+
+//
+// Register spills: FX55, FX65 and FX33 copied byte by byte against block copies
+// and 16-byte register transfers, then a spill-heavy ROM on every core.
+// Usage: bench_registers [iterations]
+//
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::DecodeCache;
+using chip8_emu::Frontend;
+using chip8_emu::Memory;
+
+static const std::vector<uint8_t> kSpillRom = {
+    0xA3, 0x00, // 0x200: I = 0x300
+    0xFF, 0x55, // 0x202: store V0-VF at I
+    0x70, 0x01, // 0x204: V0 += 1
+    0xF0, 0x33, // 0x206: BCD of V0 at I
+    0xF7, 0x65, // 0x208: V0-V7 = memory at I
+    0x71, 0x03, // 0x20A: V1 += 3
+    0xF3, 0x55, // 0x20C: store V0-V3 at I
+    0xFF, 0x65, // 0x20E: V0-VF = memory at I
+    0x12, 0x02, // 0x210: jump 0x202
+};
+
+template <typename Function>
+static double time_ns(const uint64_t iterations, Function function) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        function(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint64_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 0) : 20000000;
+
+        //
+        // Attached like in a Machine, every write invalidates decoded instructions.
+        //
+        DecodeCache decode_cache;
+        Memory<> memory;
+        memory.AttachDecodeCache(&decode_cache);
+        uint8_t v[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+        const auto address = [](const uint64_t i) { return static_cast<uint16_t>(0x300 + ((i & 0xF0) << 1)); };
+        const auto count = [](const uint64_t i) { return static_cast<uint8_t>(1 + (i & 0xF)); };
+
+        const auto byte_store = time_ns(iterations, [&](const uint64_t i) {
+            for (uint8_t r = 0; r < count(i); r++) {
+                memory.Write(v[r], static_cast<uint16_t>(address(i) + r));
+            }
+        });
+        const auto block_store = time_ns(iterations, [&](const uint64_t i) { memory.Write(v, count(i), address(i)); });
+        const auto vector_store = time_ns(iterations, [&](const uint64_t i) { memory.StoreRegisters(v, count(i), address(i)); });
+
+        const auto byte_load = time_ns(iterations, [&](const uint64_t i) {
+            for (uint8_t r = 0; r < count(i); r++) {
+                v[r] = memory.Read(static_cast<uint16_t>(address(i) + r));
+            }
+        });
+        const auto block_load = time_ns(iterations, [&](const uint64_t i) { memory.Read(address(i), v, count(i)); });
+        const auto vector_load = time_ns(iterations, [&](const uint64_t i) { memory.LoadRegisters(address(i), v, count(i)); });
+
+        std::cout << "FX55 per byte: " << byte_store << " ns, block: " << block_store << " ns, 16-byte: " << vector_store << " ns\n";
+        std::cout << "FX65 per byte: " << byte_load << " ns, block: " << block_load << " ns, 16-byte: " << vector_load << " ns\n";
+
+        for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+            Cpu<> cpu(core, Frontend::kHeadless);
+            cpu.Load(kSpillRom);
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto executed = cpu.Execute(iterations);
+            const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  spill ROM, core " << static_cast<int>(core) << ": " << executed / seconds / 1e6 << " MIPS\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+}
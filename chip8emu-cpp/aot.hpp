@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "code_map.hpp"
+#include "constants.hpp"
+#include "decode_cache.hpp"
+#include "decoder.hpp"
+
+namespace chip8_emu
+{
+    template <typename CpuType>
+    class Aot;
+
+    //
+    // [start, end) of a block compiled by chip8-aot.
+    //
+    struct CompiledBlock
+    {
+        uint16_t start;
+        uint16_t end;
+    };
+
+    //
+    // What chip8-aot generates for a ROM: the ROM itself, where its blocks are,
+    // and a function running them.
+    //
+    template <typename CpuType>
+    struct CompiledProgram
+    {
+        // Loaded at 0x200
+        std::span<const uint8_t> rom;
+
+        std::span<const CompiledBlock> blocks;
+
+        //
+        // Runs compiled blocks starting at pc, at most budget instructions.
+        // Returns how many were executed, 0 if there's no block at pc or the
+        // block there is longer than budget.
+        //
+        uint64_t (*run)(Aot<CpuType>& aot, uint64_t budget);
+    };
+
+    //
+    // Runs a CompiledProgram on a Cpu. Whatever isn't compiled, like the targets
+    // of computed jumps that static analysis couldn't see, is interpreted.
+    // Compiled bytes are watched through a CodeMap: once any of them is written,
+    // compiled code only runs again while memory still holds the original ROM there.
+    //
+    template <typename CpuType>
+    class Aot
+    {
+    public:
+        Aot(CpuType& cpu, const CompiledProgram<CpuType>& program)
+            : cpu_{ cpu }
+            , program_{ program }
+        {
+            cpu_.memory_.AttachCodeMap(&code_map_);
+            Validate();
+        }
+
+        Aot(const Aot&) = delete;
+        Aot(Aot&&) = delete;
+
+        Aot& operator=(const Aot&) = delete;
+        Aot& operator=(Aot&&) = delete;
+
+        ~Aot()
+        {
+            cpu_.memory_.AttachCodeMap(nullptr);
+        }
+
+        //
+        // Execute exactly budget instructions unless an opcode traps or FX0A waits.
+        //
+        uint64_t Execute(const uint64_t budget)
+        {
+            uint64_t executed = 0;
+            while (executed < budget && !cpu_.IsStopped())
+            {
+                if (code_map_.IsFlushPending())
+                {
+                    Validate();
+                }
+
+                if (!is_valid_)
+                {
+                    return executed + cpu_.ExecuteHandlers(budget - executed);
+                }
+
+                const auto compiled = program_.run(*this, budget - executed);
+                executed += compiled != 0 ? compiled : cpu_.ExecuteHandlers(1);
+            }
+
+            return executed;
+        }
+
+        bool IsValid() const
+        {
+            return is_valid_;
+        }
+
+        //
+        // Everything below is called by generated code.
+        //
+
+        uint16_t GetPc() const
+        {
+            return cpu_.registers_.pc;
+        }
+
+        void SetPc(const uint16_t pc)
+        {
+            cpu_.registers_.pc = pc;
+        }
+
+        //
+        // Execute one instruction. The opcode is a constant, so once Emulate is
+        // inlined only the code for that exact instruction and its operands is left.
+        //
+        template <OpcodeType kOpcode>
+        void Step()
+        {
+            constexpr auto kInstruction = Decoder::Decode(kOpcode);
+
+            DecodedInstruction decoded{};
+            decoded.instruction = kInstruction;
+            decoded.index = InstructionIndex(kInstruction);
+            decoded.opcode.first_byte = static_cast<uint8_t>(kOpcode >> 8);
+            decoded.opcode.second_byte = static_cast<uint8_t>(kOpcode);
+            decoded.x = (kOpcode >> 8) & 0xF;
+            decoded.y = (kOpcode >> 4) & 0xF;
+            decoded.n = kOpcode & 0xF;
+            decoded.nn = kOpcode & 0xFF;
+            decoded.nnn = kOpcode & 0xFFF;
+
+            cpu_.template Emulate<kInstruction>(decoded);
+        }
+
+        //
+        // Checked after instructions that may stop the machine or overwrite code.
+        //
+        bool MustExit() const
+        {
+            return cpu_.IsStopped() || code_map_.IsFlushPending();
+        }
+
+    private:
+        //
+        // Compiled code is only valid while memory holds the ROM it was compiled from.
+        //
+        void Validate()
+        {
+            code_map_.Clear();
+
+            is_valid_ = true;
+            const auto memory = cpu_.memory_.Data();
+            for (const auto& block : program_.blocks)
+            {
+                code_map_.Mark(block.start, block.end - block.start);
+                is_valid_ = is_valid_ && std::memcmp(memory + block.start, program_.rom.data() + (block.start - 0x200), block.end - block.start) == 0;
+            }
+        }
+
+        CpuType& cpu_;
+        CompiledProgram<CpuType> program_;
+        CodeMap code_map_;
+        bool is_valid_ = false;
+    };
+}
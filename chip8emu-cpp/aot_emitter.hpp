@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <ostream>
+#include <string>
+
+#include "cfg.hpp"
+#include "constants.hpp"
+#include "decoder.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Writes the C++ chip8-aot compiles a ROM to.
+    // Every basic block the control flow graph recovers becomes a labelled run of
+    // fully specialized instructions in one function, branches between blocks are
+    // direct gotos. Returns, computed jumps and code the graph didn't find go
+    // through the interpreter, see Aot.
+    //
+    class AotEmitter
+    {
+    public:
+        //
+        // The ROM, its blocks, the function running them and the CompiledProgram
+        // tying them together, all in an anonymous namespace. source only goes
+        // into the header comment.
+        //
+        static void EmitProgram(const ControlFlowGraph& cfg, const std::string& source, std::ostream& out)
+        {
+            out << std::format("// Generated by chip8-aot from {}, do not edit.\n\n", source);
+            out << "#include \"aot_main.hpp\"\n\n";
+            out << "namespace\n";
+            out << "{\n";
+            out << "using Aot = chip8_emu::Aot<chip8_emu::Cpu<>>;\n\n";
+
+            out << "const uint8_t kRom[] =\n";
+            out << "{";
+            for (size_t i = 0; i < cfg.GetRom().size(); i++)
+            {
+                out << (i % 16 == 0 ? "\n    " : " ") << std::format("{:#04x},", cfg.GetRom()[i]);
+            }
+            out << "\n};\n\n";
+
+            out << "const chip8_emu::CompiledBlock kBlocks[] =\n";
+            out << "{\n";
+            for (const auto& [start, block] : cfg.GetBlocks())
+            {
+                out << std::format("    {{ {:#05x}, {:#05x} }},\n", block.start, block.end);
+            }
+            out << "};\n\n";
+
+            out << "uint64_t Run(Aot& aot, const uint64_t budget)\n";
+            out << "{\n";
+            out << "    uint64_t executed = 0;\n\n";
+            out << "dispatch:\n";
+            out << "    switch (aot.GetPc())\n";
+            out << "    {\n";
+            for (const auto& [start, block] : cfg.GetBlocks())
+            {
+                out << std::format("    case {:#05x}: goto L_{:03x};\n", start, start);
+            }
+            out << "    default: return executed;\n";
+            out << "    }\n";
+
+            for (const auto& [start, block] : cfg.GetBlocks())
+            {
+                out << "\n";
+                EmitBlock(cfg, block, out);
+            }
+            out << "}\n\n";
+
+            out << "const chip8_emu::CompiledProgram<chip8_emu::Cpu<>> kProgram{ kRom, kBlocks, &Run };\n";
+            out << "}\n";
+        }
+
+        //
+        // main for a standalone program, after EmitProgram. See RunCompiledProgram.
+        //
+        static void EmitMain(std::ostream& out)
+        {
+            out << "\n";
+            out << "int main(int argc, char** argv)\n";
+            out << "{\n";
+            out << "    return chip8_emu::RunCompiledProgram(kProgram, argc, argv);\n";
+            out << "}\n";
+        }
+
+    private:
+        //
+        // Instructions after which the machine may have stopped or written to compiled code.
+        //
+        static bool MayExit(const Instruction instruction)
+        {
+            return instruction == Instruction::kDraw ||
+                instruction == Instruction::kStoreKeyPress ||
+                instruction == Instruction::kStoreBcdFromVx ||
+                instruction == Instruction::kStoreRegisters ||
+                instruction == Instruction::kSetRegisters;
+        }
+
+        static std::string GotoBlock(const ControlFlowGraph& cfg, const uint32_t address)
+        {
+            if (address > UINT16_MAX || cfg.FindBlock(static_cast<uint16_t>(address)) == nullptr)
+            {
+                return "return executed;";
+            }
+
+            return std::format("goto L_{:03x};", address);
+        }
+
+        static void EmitBlock(const ControlFlowGraph& cfg, const BasicBlock& block, std::ostream& out)
+        {
+            const auto size = (block.end - block.start) / 2;
+
+            out << std::format("L_{:03x}:\n", block.start);
+            out << std::format("    if (budget - executed < {})\n", size);
+            out << "    {\n";
+            out << std::format("        aot.SetPc({:#05x});\n", block.start);
+            out << "        return executed;\n";
+            out << "    }\n";
+            out << std::format("    executed += {};\n", size);
+
+            for (uint16_t pc = block.start; pc < block.end; pc += 2)
+            {
+                const auto opcode = cfg.GetOpcode(pc);
+                const auto instruction = Decoder::Decode(opcode);
+                const bool is_last = pc + 2 == block.end;
+                const auto next = static_cast<uint16_t>(pc + 2);
+
+                //
+                // Only the last instruction can read pc, and only branches and stops
+                // need it to be up to date before they run.
+                //
+                if (is_last && block.exit != BlockExit::kFallthrough)
+                {
+                    out << std::format("    aot.SetPc({:#05x});\n", next);
+                }
+
+                out << std::format("    aot.Step<0x{:04X}>(); // {:#05x}: {}\n", opcode.Value(), pc, Decoder::Disassemble(opcode));
+
+                if (MayExit(instruction) && !(is_last && block.exit == BlockExit::kStop))
+                {
+                    out << "    if (aot.MustExit())\n";
+                    out << "    {\n";
+                    out << std::format("        aot.SetPc({:#05x});\n", next);
+                    out << std::format("        return executed - {};\n", (block.end - next) / 2);
+                    out << "    }\n";
+                }
+            }
+
+            switch (block.exit)
+            {
+            case BlockExit::kFallthrough:
+                out << "    " << GotoBlock(cfg, block.end) << "\n";
+                break;
+            case BlockExit::kJump:
+                //
+                // Short backward jumps may close an idle loop, which stops the machine
+                // until Cpu::Execute skips it.
+                //
+                if (block.target <= block.end - 2 && block.end - 2 - block.target < 2 * kMaxIdleLoopLength)
+                {
+                    out << "    if (aot.MustExit())\n";
+                    out << "    {\n";
+                    out << "        return executed;\n";
+                    out << "    }\n";
+                }
+                out << "    " << GotoBlock(cfg, block.target) << "\n";
+                break;
+            case BlockExit::kCall:
+                out << "    " << GotoBlock(cfg, block.target) << "\n";
+                break;
+            case BlockExit::kSkip:
+                out << std::format("    if (aot.GetPc() == {:#05x})\n", block.end);
+                out << "    {\n";
+                out << "        " << GotoBlock(cfg, block.end) << "\n";
+                out << "    }\n";
+                out << "    " << GotoBlock(cfg, block.end + 2u) << "\n";
+                break;
+            case BlockExit::kReturn:
+            case BlockExit::kComputedJump:
+                out << "    goto dispatch;\n";
+                break;
+            case BlockExit::kStop:
+                out << "    return executed;\n";
+                break;
+            }
+        }
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "aot.hpp"
+#include "cpu.hpp"
+
+namespace chip8_emu
+{
+    //
+    // main of the programs generated by chip8-aot.
+    // Usage: program [--ipf <instructions_per_frame>] [--interpret] [--turbo [--frames <frames>]]
+    // --interpret ignores the compiled code, to compare against it.
+    //
+    inline int RunCompiledProgram(const CompiledProgram<Cpu<>>& program, const int argc, char** argv)
+    {
+        uint32_t instructions_per_frame = kDefaultInstructionsPerFrame;
+        bool is_interpreted = false;
+        bool is_turbo = false;
+        uint64_t turbo_frames = 3600;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view arg = argv[i];
+            const bool has_value = i + 1 < argc;
+
+            if (arg == "--ipf" && has_value)
+            {
+                instructions_per_frame = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (arg == "--interpret")
+            {
+                is_interpreted = true;
+            }
+            else if (arg == "--turbo")
+            {
+                is_turbo = true;
+            }
+            else if (arg == "--frames" && has_value)
+            {
+                turbo_frames = std::stoull(argv[++i]);
+            }
+            else
+            {
+                std::cout << std::format("Usage: {} [--ipf <instructions_per_frame>] [--interpret] [--turbo [--frames <frames>]]", argv[0]);
+                return 1;
+            }
+        }
+
+        try
+        {
+            Cpu<> cpu(CpuCore::kHandlerTable, is_turbo ? Frontend::kHeadless : Frontend::kWindowed);
+            cpu.Load(std::vector<uint8_t>(program.rom.begin(), program.rom.end()));
+
+            if (!is_interpreted)
+            {
+                cpu.UseCompiledProgram(program);
+            }
+
+            if (!is_turbo)
+            {
+                cpu.Run(instructions_per_frame);
+                return 0;
+            }
+
+            //
+            // Same report as the emulator's --turbo, plus the framebuffer hash
+            // to check compiled and interpreted runs against each other.
+            //
+            uint64_t executed = 0;
+            uint64_t frames = 0;
+
+            const auto start = std::chrono::steady_clock::now();
+            while (frames < turbo_frames && !cpu.IsTrapped() && !cpu.GetMemory().HasFault())
+            {
+                executed += cpu.RunFrame(instructions_per_frame);
+                frames++;
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            const auto seconds = std::max(std::chrono::duration<double>(end - start).count(), 1e-9);
+            std::cout << std::format("Executed {} instructions in {} frames, {:.3f}s\n", executed, frames, seconds);
+            std::cout << std::format("{:.0f} instructions per second, {:.0f} frames per second\n", executed / seconds, frames / seconds);
+            std::cout << std::format("Framebuffer hash {:#018x}\n", cpu.GetFramebuffer().Hash());
+
+            if (cpu.GetMemory().HasFault())
+            {
+                std::cout << std::format("Stopped at memory fault: {}\n", cpu.GetMemory().GetFault().ToString());
+            }
+            else if (cpu.IsTrapped())
+            {
+                std::cout << std::format("Stopped at invalid instruction {}\n", cpu.GetTrapOpcode().ToString());
+            }
+        }
+        catch (const std::exception& err)
+        {
+            std::cout << "Unexpected error: " << err.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+}
@@ -0,0 +1,870 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CHIP8_HAS_SSE2
+#include <immintrin.h>
+#endif
+
+#include "constants.hpp"
+#include "decode_cache.hpp"
+#include "farm.hpp"
+#include "framebuffer.hpp"
+#include "memory.hpp"
+#include "rng.hpp"
+#include "stack.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Byte-wise operations on one register across many lanes.
+    // Comparisons return 0xFF for true and 0x00 for false in every byte.
+    //
+    struct ScalarLanes
+    {
+        static constexpr size_t kWidth = 1;
+        using Vector = uint8_t;
+
+        static Vector Load(const uint8_t* p) { return *p; }
+        static void Store(uint8_t* p, const Vector v) { *p = v; }
+        static Vector Splat(const uint8_t value) { return value; }
+        static Vector Add(const Vector a, const Vector b) { return static_cast<Vector>(a + b); }
+        static Vector Sub(const Vector a, const Vector b) { return static_cast<Vector>(a - b); }
+        static Vector SubSaturate(const Vector a, const Vector b) { return a > b ? static_cast<Vector>(a - b) : 0; }
+        static Vector Or(const Vector a, const Vector b) { return a | b; }
+        static Vector And(const Vector a, const Vector b) { return a & b; }
+        static Vector Xor(const Vector a, const Vector b) { return a ^ b; }
+        static Vector AndNot(const Vector a, const Vector b) { return static_cast<Vector>(~a & b); }
+        static Vector Max(const Vector a, const Vector b) { return a > b ? a : b; }
+        static Vector Equal(const Vector a, const Vector b) { return a == b ? 0xFF : 0x00; }
+        static Vector ShiftRight(const Vector a) { return a >> 1; }
+        static Vector TopBit(const Vector a) { return a >> 7; }
+        static uint32_t MoveMask(const Vector a) { return a >> 7; }
+    };
+
+#if defined(CHIP8_HAS_SSE2)
+    struct Sse2Lanes
+    {
+        static constexpr size_t kWidth = 16;
+        using Vector = __m128i;
+
+        static Vector Load(const uint8_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+        static void Store(uint8_t* p, const Vector v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+        static Vector Splat(const uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+        static Vector Add(const Vector a, const Vector b) { return _mm_add_epi8(a, b); }
+        static Vector Sub(const Vector a, const Vector b) { return _mm_sub_epi8(a, b); }
+        static Vector SubSaturate(const Vector a, const Vector b) { return _mm_subs_epu8(a, b); }
+        static Vector Or(const Vector a, const Vector b) { return _mm_or_si128(a, b); }
+        static Vector And(const Vector a, const Vector b) { return _mm_and_si128(a, b); }
+        static Vector Xor(const Vector a, const Vector b) { return _mm_xor_si128(a, b); }
+        static Vector AndNot(const Vector a, const Vector b) { return _mm_andnot_si128(a, b); }
+        static Vector Max(const Vector a, const Vector b) { return _mm_max_epu8(a, b); }
+        static Vector Equal(const Vector a, const Vector b) { return _mm_cmpeq_epi8(a, b); }
+
+        //
+        // There are no 8-bit shifts, shift 16-bit words and drop the bits
+        // that crossed over from the neighbouring byte.
+        //
+        static Vector ShiftRight(const Vector a) { return _mm_and_si128(_mm_srli_epi16(a, 1), Splat(0x7F)); }
+        static Vector TopBit(const Vector a) { return _mm_and_si128(_mm_srli_epi16(a, 7), Splat(0x01)); }
+        static uint32_t MoveMask(const Vector a) { return static_cast<uint32_t>(_mm_movemask_epi8(a)); }
+    };
+#endif
+
+#if defined(__AVX2__)
+    struct Avx2Lanes
+    {
+        static constexpr size_t kWidth = 32;
+        using Vector = __m256i;
+
+        static Vector Load(const uint8_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void Store(uint8_t* p, const Vector v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+        static Vector Splat(const uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+        static Vector Add(const Vector a, const Vector b) { return _mm256_add_epi8(a, b); }
+        static Vector Sub(const Vector a, const Vector b) { return _mm256_sub_epi8(a, b); }
+        static Vector SubSaturate(const Vector a, const Vector b) { return _mm256_subs_epu8(a, b); }
+        static Vector Or(const Vector a, const Vector b) { return _mm256_or_si256(a, b); }
+        static Vector And(const Vector a, const Vector b) { return _mm256_and_si256(a, b); }
+        static Vector Xor(const Vector a, const Vector b) { return _mm256_xor_si256(a, b); }
+        static Vector AndNot(const Vector a, const Vector b) { return _mm256_andnot_si256(a, b); }
+        static Vector Max(const Vector a, const Vector b) { return _mm256_max_epu8(a, b); }
+        static Vector Equal(const Vector a, const Vector b) { return _mm256_cmpeq_epi8(a, b); }
+        static Vector ShiftRight(const Vector a) { return _mm256_and_si256(_mm256_srli_epi16(a, 1), Splat(0x7F)); }
+        static Vector TopBit(const Vector a) { return _mm256_and_si256(_mm256_srli_epi16(a, 7), Splat(0x01)); }
+        static uint32_t MoveMask(const Vector a) { return static_cast<uint32_t>(_mm256_movemask_epi8(a)); }
+    };
+#endif
+
+    //
+    // Widest lane operations the build targets that evenly divide a register row.
+    //
+    template <size_t kStride>
+    using LaneOps =
+#if defined(__AVX2__)
+        std::conditional_t<kStride % Avx2Lanes::kWidth == 0, Avx2Lanes, Sse2Lanes>;
+#elif defined(CHIP8_HAS_SSE2)
+        Sse2Lanes;
+#else
+        ScalarLanes;
+#endif
+
+    //
+    // Runs up to kLanes headless machines on the same ROM in lockstep.
+    // Registers and timers are stored structure-of-arrays, one row of kLanes bytes
+    // per register, so an instruction executes on every lane with a few vector operations.
+    //
+    // Every step, each running lane executes exactly one instruction. While every lane is
+    // at the same pc they share a single pc and execute each instruction together, ALU,
+    // timer and skip instructions with SIMD and the rest lane by lane. When lanes diverge
+    // they're split into groups by pc, in the worst case one lane per group, until they
+    // meet at the same pc again.
+    //
+    // Lanes behave exactly like a headless Cpu with the same seed.
+    //
+    template <size_t kLanes>
+    class Batch
+    {
+    public:
+        static_assert(kLanes == 8 || kLanes == 16 || kLanes == 32, "Batches have 8, 16 or 32 lanes");
+
+        using LaneMask = uint32_t;
+
+        Batch(const std::vector<uint8_t>& rom, const std::vector<uint32_t>& seeds)
+            : results_(seeds.size())
+        {
+            if (seeds.size() > kLanes)
+            {
+                throw std::runtime_error{ std::format("A batch can run at most {} instances, got {}", kLanes, seeds.size()) };
+            }
+
+            for (size_t lane = 0; lane < seeds.size(); lane++)
+            {
+                memory_[lane].Write(rom, 0x200);
+                ram_[lane] = memory_[lane].Data();
+                pc_[lane] = 0x200;
+                rngs_[lane].Seed(seeds[lane]);
+                active_ |= LaneBit(lane);
+            }
+
+            decoded_.fill(DecodedInstruction::From(Opcode{}, Machine::LookupInstruction(0)));
+        }
+
+        Batch(const Batch&) = delete;
+        Batch(Batch&&) = delete;
+
+        Batch& operator=(const Batch&) = delete;
+        Batch& operator=(Batch&&) = delete;
+
+        ~Batch() = default;
+
+        size_t GetLaneCount() const
+        {
+            return results_.size();
+        }
+
+        LaneMask GetActiveLanes() const
+        {
+            return active_;
+        }
+
+        Registers GetRegisters(const size_t lane) const
+        {
+            Registers registers{};
+            registers.pc = LanePc(lane);
+            registers.index = index_[lane];
+            registers.delay_timer = delay_timer_[lane];
+            registers.sound_timer = sound_timer_[lane];
+            for (size_t i = 0; i < kNumberOfGeneralRegisters; i++)
+            {
+                registers.v[i] = v_[i][lane];
+            }
+
+            return registers;
+        }
+
+        const Framebuffer& GetFramebuffer(const size_t lane) const
+        {
+            return framebuffers_[lane];
+        }
+
+        //
+        // Steps where every running lane executed the same instruction together,
+        // and steps where they had to be split into groups.
+        //
+        uint64_t GetLockstepSteps() const
+        {
+            return lockstep_steps_;
+        }
+
+        uint64_t GetDivergentSteps() const
+        {
+            return divergent_steps_;
+        }
+
+        //
+        // Every running lane executes one instruction.
+        //
+        void Step()
+        {
+            auto pending = active_;
+            uint32_t groups = 0;
+            while (pending != 0)
+            {
+                pending &= ~ExecuteGroup(pending);
+                groups++;
+            }
+
+            if (groups <= 1)
+            {
+                lockstep_steps_++;
+            }
+            else
+            {
+                divergent_steps_++;
+            }
+
+            if (!is_converged_)
+            {
+                TryConverge();
+            }
+
+            step_count_++;
+        }
+
+        //
+        // Emulate one 60Hz frame on every running lane, like Cpu::RunFrame.
+        //
+        void RunFrame(const uint32_t instructions_per_frame)
+        {
+            const auto running = active_;
+            for (uint32_t i = 0; i < instructions_per_frame && active_ != 0; i++)
+            {
+                Step();
+            }
+
+            //
+            // Lanes that threw never got to the end of the frame.
+            // Waiting lanes keep ticking until there's nothing left to tick.
+            //
+            TickTimers((running | waiting_) & ~failed_);
+            ForEachLane(waiting_, [&](const size_t lane)
+            {
+                if (delay_timer_[lane] == 0 && sound_timer_[lane] == 0)
+                {
+                    Park(lane);
+                }
+            });
+            frame_count_++;
+        }
+
+        //
+        // Run up to frames frames, or until every lane has stopped.
+        //
+        const std::vector<FarmResult>& Run(const uint64_t frames, const uint32_t instructions_per_frame = kDefaultInstructionsPerFrame)
+        {
+            for (uint64_t frame = 0; frame < frames && (active_ | waiting_) != 0; frame++)
+            {
+                RunFrame(instructions_per_frame);
+            }
+
+            return GetResults();
+        }
+
+        const std::vector<FarmResult>& GetResults()
+        {
+            for (size_t lane = 0; lane < results_.size(); lane++)
+            {
+                if (active_ & LaneBit(lane))
+                {
+                    results_[lane].instructions = step_count_;
+                    results_[lane].frames = frame_count_;
+                }
+                else if (waiting_ & LaneBit(lane))
+                {
+                    results_[lane].frames = frame_count_;
+                }
+
+                results_[lane].framebuffer_hash = framebuffers_[lane].Hash();
+            }
+
+            return results_;
+        }
+
+    private:
+        //
+        // Register rows are padded to a whole SSE register.
+        //
+        static constexpr size_t kStride = kLanes < 16 ? 16 : kLanes;
+
+        using Ops = LaneOps<kStride>;
+
+        static constexpr LaneMask LaneBit(const size_t lane)
+        {
+            return LaneMask{ 1 } << lane;
+        }
+
+        template <typename Function>
+        static void ForEachLane(LaneMask lanes, Function function)
+        {
+            while (lanes != 0)
+            {
+                function(static_cast<size_t>(std::countr_zero(lanes)));
+                lanes &= lanes - 1;
+            }
+        }
+
+        uint16_t LanePc(const size_t lane) const
+        {
+            return is_converged_ && (active_ & LaneBit(lane)) ? shared_pc_ : pc_[lane];
+        }
+
+        //
+        // Give every running lane its own pc again.
+        //
+        void Diverge()
+        {
+            if (is_converged_)
+            {
+                ForEachLane(active_, [&](const size_t lane) { pc_[lane] = shared_pc_; });
+                is_converged_ = false;
+            }
+        }
+
+        void TryConverge()
+        {
+            if (active_ == 0)
+            {
+                return;
+            }
+
+            const auto pc = pc_[std::countr_zero(active_)];
+            bool is_converged = true;
+            ForEachLane(active_, [&](const size_t lane) { is_converged &= pc_[lane] == pc; });
+            if (is_converged)
+            {
+                shared_pc_ = pc;
+                is_converged_ = true;
+            }
+        }
+
+        void SetPc(const LaneMask lanes, const uint16_t pc)
+        {
+            if (is_converged_)
+            {
+                shared_pc_ = pc;
+            }
+            else
+            {
+                ForEachLane(lanes, [&](const size_t lane) { pc_[lane] = pc; });
+            }
+        }
+
+        //
+        // Skip the next instruction on the taken lanes out of the group.
+        //
+        void Skip(LaneMask taken, const LaneMask group)
+        {
+            const auto live = group & active_;
+            taken &= live;
+            if (taken == 0)
+            {
+                return;
+            }
+
+            if (is_converged_ && taken == live)
+            {
+                shared_pc_ += 2;
+                return;
+            }
+
+            Diverge();
+            ForEachLane(taken, [&](const size_t lane) { pc_[lane] += 2; });
+        }
+
+        //
+        // Execute the instruction at the first pending lane's pc on every pending lane
+        // that is at the same pc and sees the same opcode there.
+        // Returns the lanes that executed it.
+        //
+        LaneMask ExecuteGroup(const LaneMask pending)
+        {
+            const auto leader = static_cast<size_t>(std::countr_zero(pending));
+            const auto pc = LanePc(leader);
+            if (pc + 1 >= kMemorySize)
+            {
+                //
+                // Fetches running past the end of memory wrap around, or fault with
+                // checked memory. Rare enough to run the leader on its own.
+                //
+                Diverge();
+                auto next_pc = pc;
+                const auto opcode = memory_[leader].FetchOpcode(next_pc);
+                pc_[leader] = next_pc;
+                if (memory_[leader].HasFault())
+                {
+                    Fail(leader, std::format("Memory fault: {}", memory_[leader].GetFault().ToString()));
+                }
+                else
+                {
+                    Execute(DecodedInstruction::From(opcode, Machine::LookupInstruction(opcode.Value())), LaneBit(leader));
+                }
+
+                return LaneBit(leader);
+            }
+
+            const auto first_byte = ram_[leader][pc];
+            const auto second_byte = ram_[leader][pc + 1];
+
+            //
+            // Converged lanes only need their opcodes compared where
+            // some lane may have overwritten the ROM.
+            //
+            auto group = pending;
+            if (!is_converged_ || written_[pc] || written_[pc + 1])
+            {
+                group = 0;
+                ForEachLane(pending, [&](const size_t lane)
+                {
+                    if (LanePc(lane) == pc && ram_[lane][pc] == first_byte && ram_[lane][pc + 1] == second_byte)
+                    {
+                        group |= LaneBit(lane);
+                    }
+                });
+
+                if (group != pending)
+                {
+                    Diverge();
+                }
+            }
+
+            if (is_converged_)
+            {
+                shared_pc_ += 2;
+            }
+            else
+            {
+                ForEachLane(group, [&](const size_t lane) { pc_[lane] += 2; });
+            }
+
+            Execute(Decode(pc, first_byte, second_byte), group);
+
+            return group;
+        }
+
+        //
+        // Decoded instructions are looked up by pc and checked against the opcode,
+        // so writes by any lane never have to invalidate anything. Odd addresses
+        // share the slot below them, decoding only depends on the opcode anyway.
+        //
+        const DecodedInstruction& Decode(const uint16_t pc, const uint8_t first_byte, const uint8_t second_byte)
+        {
+            auto& decoded = decoded_[pc / 2];
+            if (decoded.opcode.first_byte != first_byte || decoded.opcode.second_byte != second_byte)
+            {
+                Opcode opcode;
+                opcode.first_byte = first_byte;
+                opcode.second_byte = second_byte;
+                decoded = DecodedInstruction::From(opcode, Machine::LookupInstruction(opcode.Value()));
+            }
+
+            return decoded;
+        }
+
+        const uint8_t* MaskFor(const LaneMask lanes)
+        {
+            if (lanes != mask_lanes_)
+            {
+                for (size_t lane = 0; lane < kStride; lane++)
+                {
+                    mask_[lane] = (lanes & LaneBit(lane)) ? 0xFF : 0x00;
+                }
+                mask_lanes_ = lanes;
+            }
+
+            return mask_;
+        }
+
+        //
+        // destination = function(a, b) on the lanes in the mask, other lanes are left alone.
+        // destination may be a or b.
+        //
+        template <typename Function>
+        static void Apply(uint8_t* destination, const uint8_t* a, const uint8_t* b, const uint8_t* mask, Function function)
+        {
+            for (size_t i = 0; i < kStride; i += Ops::kWidth)
+            {
+                const auto result = function(Ops::Load(a + i), Ops::Load(b + i));
+                const auto selected = Ops::Load(mask + i);
+                Ops::Store(destination + i, Ops::Or(Ops::And(selected, result), Ops::AndNot(selected, Ops::Load(destination + i))));
+            }
+        }
+
+        //
+        // Skip the next instruction on every lane in the group where the condition holds.
+        //
+        template <typename Function>
+        void SkipIf(const uint8_t* a, const uint8_t* b, const LaneMask group, Function condition)
+        {
+            LaneMask taken = 0;
+            for (size_t i = 0; i < kStride; i += Ops::kWidth)
+            {
+                taken |= Ops::MoveMask(condition(Ops::Load(a + i), Ops::Load(b + i))) << i;
+            }
+
+            Skip(taken, group);
+        }
+
+        //
+        // Lanes that wrote to memory may now see different code than the others.
+        // Writes wrap around the end of memory like Memory does.
+        //
+        void MarkWritten(const uint32_t address, const uint32_t size)
+        {
+            for (uint32_t i = 0; i < size; i++)
+            {
+                written_[(address + i) % kMemorySize] = true;
+            }
+        }
+
+        //
+        // Run function on every lane in the group, a lane that throws or faults
+        // stops with an error.
+        //
+        template <typename Function>
+        void PerLane(const LaneMask group, Function function)
+        {
+            ForEachLane(group, [&](const size_t lane)
+            {
+                try
+                {
+                    function(lane);
+                }
+                catch (const std::exception& e)
+                {
+                    Fail(lane, e.what());
+                }
+
+                if (memory_[lane].HasFault())
+                {
+                    Fail(lane, std::format("Memory fault: {}", memory_[lane].GetFault().ToString()));
+                }
+            });
+        }
+
+        void Execute(const DecodedInstruction& decoded, const LaneMask group)
+        {
+            const auto mask = MaskFor(group);
+            const auto vx = v_[decoded.x];
+            const auto vy = v_[decoded.y];
+            const auto vf = v_[0xF];
+            const auto one = Ops::Splat(1);
+
+            switch (decoded.instruction)
+            {
+            case Instruction::kSetVxRegister:
+            {
+                const auto value = Ops::Splat(decoded.nn);
+                Apply(vx, vx, vx, mask, [=](auto, auto) { return value; });
+                break;
+            }
+            case Instruction::kAddToRegister:
+            {
+                const auto value = Ops::Splat(decoded.nn);
+                Apply(vx, vx, vx, mask, [=](auto a, auto) { return Ops::Add(a, value); });
+                break;
+            }
+            case Instruction::kSetVxVy:
+                Apply(vx, vx, vy, mask, [](auto, auto b) { return b; });
+                break;
+            case Instruction::kOrVxVy:
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::Or(a, b); });
+                break;
+            case Instruction::kAndVxVy:
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::And(a, b); });
+                break;
+            case Instruction::kXorVxVy:
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::Xor(a, b); });
+                break;
+
+            //
+            // Same order as Machine: VF first, then Vx, which may be VF.
+            //
+            case Instruction::kAddVxVy:
+                Apply(vf, vx, vy, mask, [=](auto a, auto b)
+                {
+                    const auto sum = Ops::Add(a, b);
+                    return Ops::AndNot(Ops::Equal(Ops::Max(sum, a), sum), one);
+                });
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::Add(a, b); });
+                break;
+            case Instruction::kSubVxVy:
+                Apply(vf, vx, vy, mask, [=](auto a, auto b) { return Ops::And(Ops::Equal(Ops::Max(a, b), a), one); });
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::Sub(a, b); });
+                break;
+            case Instruction::kSubnVxVy:
+                Apply(vf, vx, vy, mask, [=](auto a, auto b) { return Ops::And(Ops::Equal(Ops::Max(b, a), b), one); });
+                Apply(vx, vx, vy, mask, [](auto a, auto b) { return Ops::Sub(b, a); });
+                break;
+            case Instruction::kShrVxVy:
+                Apply(vf, vx, vx, mask, [=](auto a, auto) { return Ops::And(a, one); });
+                Apply(vx, vx, vx, mask, [](auto a, auto) { return Ops::ShiftRight(a); });
+                break;
+            case Instruction::kShlVxVy:
+                Apply(vf, vx, vx, mask, [](auto a, auto) { return Ops::TopBit(a); });
+                Apply(vx, vx, vx, mask, [](auto a, auto) { return Ops::Add(a, a); });
+                break;
+
+            case Instruction::kStoreDelayTimer:
+                Apply(vx, vx, delay_timer_, mask, [](auto, auto b) { return b; });
+                break;
+            case Instruction::kSetDelayTimer:
+                Apply(delay_timer_, delay_timer_, vx, mask, [](auto, auto b) { return b; });
+                break;
+            case Instruction::kSetSoundTimer:
+                Apply(sound_timer_, sound_timer_, vx, mask, [](auto, auto b) { return b; });
+                break;
+
+            case Instruction::kSkipNextInstructionIfEq:
+            {
+                const auto value = Ops::Splat(decoded.nn);
+                SkipIf(vx, vx, group, [=](auto a, auto) { return Ops::Equal(a, value); });
+                break;
+            }
+            case Instruction::kSkipNextInstructionIfNotEq:
+            {
+                const auto value = Ops::Splat(decoded.nn);
+                SkipIf(vx, vx, group, [=](auto a, auto) { return Ops::AndNot(Ops::Equal(a, value), Ops::Splat(0xFF)); });
+                break;
+            }
+            case Instruction::kSkipNextInstructionIfXEqY:
+                SkipIf(vx, vy, group, [](auto a, auto b) { return Ops::Equal(a, b); });
+                break;
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+                SkipIf(vx, vy, group, [](auto a, auto b) { return Ops::AndNot(Ops::Equal(a, b), Ops::Splat(0xFF)); });
+                break;
+
+            case Instruction::kJump:
+                SetPc(group, decoded.nnn);
+                break;
+            case Instruction::kCall:
+                PerLane(group, [&](const size_t lane) { stacks_[lane].push(LanePc(lane)); });
+                SetPc(group & active_, decoded.nnn);
+                break;
+
+            //
+            // Targets depend on lane state, let Step converge the lanes again if they agree.
+            //
+            case Instruction::kJumpOffset:
+                Diverge();
+                ForEachLane(group, [&](const size_t lane) { pc_[lane] = decoded.nnn + v_[0][lane]; });
+                break;
+            case Instruction::kReturn:
+                Diverge();
+                PerLane(group, [&](const size_t lane) { pc_[lane] = stacks_[lane].pop(); });
+                break;
+
+            case Instruction::kSetIndexRegister:
+                ForEachLane(group, [&](const size_t lane) { index_[lane] = decoded.nnn; });
+                break;
+            case Instruction::kAddIVx:
+                ForEachLane(group, [&](const size_t lane) { index_[lane] = index_[lane] + vx[lane]; });
+                break;
+            case Instruction::kSetSpriteFromVx:
+                ForEachLane(group, [&](const size_t lane) { index_[lane] = kSpritesAddress + kSpriteSize * vx[lane]; });
+                break;
+
+            case Instruction::kRandom:
+                ForEachLane(group, [&](const size_t lane) { vx[lane] = rngs_[lane].NextByte() & decoded.nn; });
+                break;
+
+            case Instruction::kClearScreen:
+                ForEachLane(group, [&](const size_t lane) { framebuffers_[lane].Clear(); });
+                break;
+            case Instruction::kDraw:
+                PerLane(group, [&](const size_t lane)
+                {
+                    const uint8_t* sprite = memory_[lane].View(index_[lane], decoded.n);
+                    const auto pixel_turned_off = framebuffers_[lane].Draw(vx[lane], vy[lane], sprite, decoded.n);
+                    vf[lane] = pixel_turned_off ? 0x1 : 0x0;
+                });
+                break;
+
+            //
+            // Batches are headless, every key reads as released.
+            //
+            case Instruction::kSkipIfPressed:
+            case Instruction::kSkipIfNotPressed:
+                PerLane(group, [&](const size_t lane)
+                {
+                    if (vx[lane] >= 0x10)
+                    {
+                        throw std::runtime_error{ std::format("Could not find {:#x} key", vx[lane]) };
+                    }
+                });
+
+                if (decoded.instruction == Instruction::kSkipIfNotPressed)
+                {
+                    Skip(group, group);
+                }
+                break;
+            //
+            // No key is ever pressed, the lanes stop like a headless Machine does.
+            //
+            case Instruction::kStoreKeyPress:
+                ForEachLane(group, [&](const size_t lane) { Wait(lane); });
+                break;
+
+            //
+            // Registers are stored by row, so they're gathered into or scattered
+            // from a block that's copied to or from memory in one go.
+            //
+            case Instruction::kStoreBcdFromVx:
+                PerLane(group, [&](const size_t lane)
+                {
+                    const uint8_t digits[] = {
+                        static_cast<uint8_t>(vx[lane] / 100),
+                        static_cast<uint8_t>(vx[lane] / 10 % 10),
+                        static_cast<uint8_t>(vx[lane] % 10),
+                    };
+                    MarkWritten(index_[lane], sizeof(digits));
+                    memory_[lane].Write(digits, sizeof(digits), index_[lane]);
+                });
+                break;
+            case Instruction::kStoreRegisters:
+                PerLane(group, [&](const size_t lane)
+                {
+                    uint8_t block[kNumberOfGeneralRegisters];
+                    for (uint8_t i = 0; i <= decoded.x; i++)
+                    {
+                        block[i] = v_[i][lane];
+                    }
+
+                    MarkWritten(index_[lane], decoded.x + 1);
+                    memory_[lane].Write(block, decoded.x + 1, index_[lane]);
+                });
+                break;
+            case Instruction::kSetRegisters:
+                PerLane(group, [&](const size_t lane)
+                {
+                    uint8_t block[kNumberOfGeneralRegisters];
+                    memory_[lane].Read(index_[lane], block, decoded.x + 1);
+                    for (uint8_t i = 0; i <= decoded.x; i++)
+                    {
+                        v_[i][lane] = block[i];
+                    }
+                });
+                break;
+
+            default:
+                ForEachLane(group, [&](const size_t lane) { Trap(lane); });
+                break;
+            }
+        }
+
+        void TickTimers(const LaneMask lanes)
+        {
+            const auto mask = MaskFor(lanes);
+            const auto one = Ops::Splat(1);
+            Apply(delay_timer_, delay_timer_, delay_timer_, mask, [=](auto a, auto) { return Ops::SubSaturate(a, one); });
+            Apply(sound_timer_, sound_timer_, sound_timer_, mask, [=](auto a, auto) { return Ops::SubSaturate(a, one); });
+        }
+
+        //
+        // Counts match Cpu and Farm: a trapping instruction and its frame count,
+        // an instruction that throws doesn't.
+        //
+        void Trap(const size_t lane)
+        {
+            pc_[lane] = LanePc(lane);
+            results_[lane].exit_reason = ExitReason::kTrapped;
+            results_[lane].instructions = step_count_ + 1;
+            results_[lane].frames = frame_count_ + 1;
+            active_ &= ~LaneBit(lane);
+        }
+
+        void Wait(const size_t lane)
+        {
+            pc_[lane] = LanePc(lane);
+            results_[lane].instructions = step_count_ + 1;
+            active_ &= ~LaneBit(lane);
+            waiting_ |= LaneBit(lane);
+        }
+
+        void Park(const size_t lane)
+        {
+            results_[lane].exit_reason = ExitReason::kWaitingForKey;
+            results_[lane].frames = frame_count_ + 1;
+            waiting_ &= ~LaneBit(lane);
+        }
+
+        void Fail(const size_t lane, const std::string& error)
+        {
+            pc_[lane] = LanePc(lane);
+            results_[lane].exit_reason = ExitReason::kError;
+            results_[lane].error = error;
+            results_[lane].instructions = step_count_;
+            results_[lane].frames = frame_count_;
+            active_ &= ~LaneBit(lane);
+            failed_ |= LaneBit(lane);
+        }
+
+        //
+        // Structure-of-arrays machine state, one row per register.
+        //
+        alignas(32) uint8_t v_[kNumberOfGeneralRegisters][kStride] = {};
+        alignas(32) uint8_t delay_timer_[kStride] = {};
+        alignas(32) uint8_t sound_timer_[kStride] = {};
+        uint16_t pc_[kLanes] = {};
+        uint16_t index_[kLanes] = {};
+
+        //
+        // While converged every running lane is at shared_pc_ and pc_ is stale.
+        //
+        bool is_converged_ = true;
+        uint16_t shared_pc_ = 0x200;
+
+        //
+        // Addresses any lane has written to since the ROM was loaded.
+        //
+        std::bitset<kMemorySize> written_;
+
+        //
+        // Byte mask of mask_lanes_, rebuilt only when the group changes.
+        //
+        alignas(32) uint8_t mask_[kStride] = {};
+        LaneMask mask_lanes_ = 0;
+
+        std::array<Memory<>, kLanes> memory_;
+        std::array<const uint8_t*, kLanes> ram_{};
+        std::array<Stack, kLanes> stacks_;
+        std::array<Framebuffer, kLanes> framebuffers_;
+        std::array<Rng, kLanes> rngs_;
+        std::array<DecodedInstruction, kMemorySize / 2> decoded_;
+
+        //
+        // Lanes still executing, lanes that FX0A stopped until their timers run out
+        // and lanes that threw.
+        //
+        LaneMask active_ = 0;
+        LaneMask waiting_ = 0;
+        LaneMask failed_ = 0;
+
+        uint64_t step_count_ = 0;
+        uint64_t frame_count_ = 0;
+        uint64_t lockstep_steps_ = 0;
+        uint64_t divergent_steps_ = 0;
+
+        std::vector<FarmResult> results_;
+    };
+}
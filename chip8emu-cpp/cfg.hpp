@@ -0,0 +1,433 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "decoder.hpp"
+
+namespace chip8_emu
+{
+    //
+    // How control leaves a basic block.
+    //
+    enum class BlockExit : uint8_t
+    {
+        // Runs into the next block, which something else branches to
+        kFallthrough,
+
+        // 1NNN
+        kJump,
+
+        // 3XNN, 4XNN, 5XY0, 9XY0, EX9E and EXA1: the next instruction or the one after it
+        kSkip,
+
+        // 2NNN, continues at the next instruction once the callee returns
+        kCall,
+
+        // 00EE
+        kReturn,
+
+        // BNNN, the target depends on V0 so it can't be followed
+        kComputedJump,
+
+        // 0NNN and invalid opcodes trap, and code may run off the end of the ROM
+        kStop,
+    };
+
+    struct BasicBlock
+    {
+        uint16_t start = 0;
+
+        // One past the last instruction
+        uint16_t end = 0;
+
+        BlockExit exit = BlockExit::kStop;
+
+        // Jump and call target, or the base address of a computed jump
+        uint16_t target = 0;
+
+        // Blocks of the same function that may run next, the return site for calls
+        std::vector<uint16_t> successors;
+    };
+
+    //
+    // A subroutine: the entry point or a 2NNN target, with the blocks reachable
+    // from it without following calls, and the subroutines it calls.
+    //
+    struct Function
+    {
+        uint16_t entry = 0;
+        std::vector<uint16_t> blocks;
+        std::vector<uint16_t> callees;
+    };
+
+    //
+    // Bytes of the ROM that are never reached as code.
+    //
+    struct DataRegion
+    {
+        uint16_t start = 0;
+        uint16_t end = 0;
+
+        // Some ANNN points into it, most likely sprites or tables
+        bool is_referenced = false;
+    };
+
+    //
+    // Control flow graph of a ROM, recovered statically by following every
+    // jump, call and skip from the entry point. Only code reachable that way is
+    // found: computed jumps end their block without successors.
+    // Cores and compilers can take block boundaries from here instead of
+    // discovering them while running.
+    //
+    class ControlFlowGraph
+    {
+    public:
+        explicit ControlFlowGraph(const std::vector<uint8_t>& rom, const uint16_t base = 0x200)
+            : rom_{ rom }
+            , base_{ base }
+            , is_code_(rom.size(), false)
+        {
+            FindCode();
+            BuildBlocks();
+            BuildFunctions();
+            FindData();
+        }
+
+        ControlFlowGraph(const ControlFlowGraph&) = delete;
+        ControlFlowGraph(ControlFlowGraph&&) = delete;
+
+        ControlFlowGraph& operator=(const ControlFlowGraph&) = delete;
+        ControlFlowGraph& operator=(ControlFlowGraph&&) = delete;
+
+        ~ControlFlowGraph() = default;
+
+        uint16_t GetBase() const
+        {
+            return base_;
+        }
+
+        const std::vector<uint8_t>& GetRom() const
+        {
+            return rom_;
+        }
+
+        //
+        // Blocks by start address.
+        //
+        const std::map<uint16_t, BasicBlock>& GetBlocks() const
+        {
+            return blocks_;
+        }
+
+        const BasicBlock* FindBlock(const uint16_t start) const
+        {
+            const auto it = blocks_.find(start);
+            return it != blocks_.end() ? &it->second : nullptr;
+        }
+
+        //
+        // Functions by entry address. The ROM's entry point is one of them.
+        //
+        const std::map<uint16_t, Function>& GetFunctions() const
+        {
+            return functions_;
+        }
+
+        const std::vector<DataRegion>& GetDataRegions() const
+        {
+            return data_regions_;
+        }
+
+        //
+        // Addresses loaded into I by ANNN anywhere in the code.
+        // The ones inside code are where the ROM might modify itself.
+        //
+        const std::set<uint16_t>& GetIndexTargets() const
+        {
+            return index_targets_;
+        }
+
+        bool IsCode(const uint16_t address) const
+        {
+            return IsInRom(address, 1) && is_code_[address - base_];
+        }
+
+        bool HasComputedJumps() const
+        {
+            return has_computed_jumps_;
+        }
+
+        Opcode GetOpcode(const uint16_t address) const
+        {
+            Opcode opcode;
+            opcode.first_byte = rom_[address - base_];
+            opcode.second_byte = rom_[address - base_ + 1];
+
+            return opcode;
+        }
+
+    private:
+        bool IsInRom(const uint16_t address, const size_t size) const
+        {
+            return address >= base_ && address - base_ + size <= rom_.size();
+        }
+
+        static bool IsSkip(const Instruction instruction)
+        {
+            return instruction == Instruction::kSkipNextInstructionIfEq ||
+                instruction == Instruction::kSkipNextInstructionIfNotEq ||
+                instruction == Instruction::kSkipNextInstructionIfXEqY ||
+                instruction == Instruction::kSkipNextInstructionIfXNotEqY ||
+                instruction == Instruction::kSkipIfPressed ||
+                instruction == Instruction::kSkipIfNotPressed;
+        }
+
+        static BlockExit ExitOf(const Instruction instruction)
+        {
+            switch (instruction)
+            {
+            case Instruction::kJump:
+                return BlockExit::kJump;
+            case Instruction::kCall:
+                return BlockExit::kCall;
+            case Instruction::kReturn:
+                return BlockExit::kReturn;
+            case Instruction::kJumpOffset:
+                return BlockExit::kComputedJump;
+            case Instruction::kSys:
+            case Instruction::kInvalid:
+                return BlockExit::kStop;
+            default:
+                return IsSkip(instruction) ? BlockExit::kSkip : BlockExit::kFallthrough;
+            }
+        }
+
+        //
+        // Recursive descent from the entry point, every branch target starts a block.
+        // Instructions are marked by their start address: a branch into the middle
+        // of one decodes a different instruction stream over the same bytes.
+        //
+        void FindCode()
+        {
+            std::vector<bool> is_traced(rom_.size(), false);
+            std::vector<uint16_t> pending;
+            const auto branch_to = [&](const uint16_t target)
+            {
+                if (IsInRom(target, 2) && leaders_.insert(target).second)
+                {
+                    pending.push_back(target);
+                }
+            };
+
+            branch_to(base_);
+            while (!pending.empty())
+            {
+                auto pc = pending.back();
+                pending.pop_back();
+
+                while (IsInRom(pc, 2) && !is_traced[pc - base_])
+                {
+                    is_traced[pc - base_] = true;
+                    is_code_[pc - base_] = true;
+                    is_code_[pc - base_ + 1] = true;
+
+                    const auto opcode = GetOpcode(pc);
+                    const auto instruction = Decoder::Decode(opcode);
+                    const auto nnn = static_cast<uint16_t>(opcode.Value() & 0xFFF);
+
+                    if (instruction == Instruction::kSetIndexRegister)
+                    {
+                        index_targets_.insert(nnn);
+                    }
+
+                    const auto exit = ExitOf(instruction);
+                    if (exit == BlockExit::kJump)
+                    {
+                        branch_to(nnn);
+                    }
+                    else if (exit == BlockExit::kCall)
+                    {
+                        calls_.insert(nnn);
+                        branch_to(nnn);
+                        branch_to(pc + 2);
+                    }
+                    else if (exit == BlockExit::kSkip)
+                    {
+                        branch_to(pc + 2);
+                        branch_to(pc + 4);
+                    }
+                    else if (exit == BlockExit::kComputedJump)
+                    {
+                        has_computed_jumps_ = true;
+                    }
+
+                    if (exit != BlockExit::kFallthrough)
+                    {
+                        break;
+                    }
+
+                    pc += 2;
+                }
+            }
+        }
+
+        void BuildBlocks()
+        {
+            for (const auto leader : leaders_)
+            {
+                BasicBlock block;
+                block.start = leader;
+
+                auto pc = leader;
+                while (true)
+                {
+                    const auto opcode = GetOpcode(pc);
+                    block.exit = ExitOf(Decoder::Decode(opcode));
+                    block.target = static_cast<uint16_t>(opcode.Value() & 0xFFF);
+                    pc += 2;
+
+                    if (block.exit != BlockExit::kFallthrough)
+                    {
+                        break;
+                    }
+
+                    if (!IsInRom(pc, 2))
+                    {
+                        block.exit = BlockExit::kStop;
+                        break;
+                    }
+
+                    if (leaders_.contains(pc))
+                    {
+                        break;
+                    }
+                }
+
+                block.end = pc;
+                if (block.exit != BlockExit::kJump && block.exit != BlockExit::kCall && block.exit != BlockExit::kComputedJump)
+                {
+                    block.target = 0;
+                }
+
+                const auto add_successor = [&](const uint16_t address)
+                {
+                    if (leaders_.contains(address))
+                    {
+                        block.successors.push_back(address);
+                    }
+                };
+
+                switch (block.exit)
+                {
+                case BlockExit::kFallthrough:
+                case BlockExit::kCall:
+                    add_successor(block.end);
+                    break;
+                case BlockExit::kJump:
+                    add_successor(block.target);
+                    break;
+                case BlockExit::kSkip:
+                    add_successor(block.end);
+                    add_successor(block.end + 2);
+                    break;
+                default:
+                    break;
+                }
+
+                blocks_.emplace(leader, std::move(block));
+            }
+        }
+
+        void BuildFunctions()
+        {
+            std::set<uint16_t> entries = { base_ };
+            for (const auto call : calls_)
+            {
+                if (leaders_.contains(call))
+                {
+                    entries.insert(call);
+                }
+            }
+
+            for (const auto entry : entries)
+            {
+                Function function;
+                function.entry = entry;
+
+                std::set<uint16_t> seen = { entry };
+                std::set<uint16_t> callees;
+                std::vector<uint16_t> pending = { entry };
+                while (!pending.empty())
+                {
+                    const auto& block = blocks_.at(pending.back());
+                    pending.pop_back();
+
+                    if (block.exit == BlockExit::kCall && leaders_.contains(block.target))
+                    {
+                        callees.insert(block.target);
+                    }
+
+                    for (const auto successor : block.successors)
+                    {
+                        if (seen.insert(successor).second)
+                        {
+                            pending.push_back(successor);
+                        }
+                    }
+                }
+
+                function.blocks.assign(seen.begin(), seen.end());
+                function.callees.assign(callees.begin(), callees.end());
+                functions_.emplace(entry, std::move(function));
+            }
+        }
+
+        void FindData()
+        {
+            for (size_t offset = 0; offset < rom_.size();)
+            {
+                if (is_code_[offset])
+                {
+                    offset++;
+                    continue;
+                }
+
+                DataRegion region;
+                region.start = static_cast<uint16_t>(base_ + offset);
+                while (offset < rom_.size() && !is_code_[offset])
+                {
+                    offset++;
+                }
+                region.end = static_cast<uint16_t>(base_ + offset);
+
+                const auto reference = index_targets_.lower_bound(region.start);
+                region.is_referenced = reference != index_targets_.end() && *reference < region.end;
+
+                data_regions_.push_back(region);
+            }
+        }
+
+        std::vector<uint8_t> rom_;
+        uint16_t base_;
+
+        //
+        // One flag per ROM byte, set for both bytes of every reachable instruction.
+        //
+        std::vector<bool> is_code_;
+
+        std::set<uint16_t> leaders_;
+        std::set<uint16_t> calls_;
+        std::set<uint16_t> index_targets_;
+        bool has_computed_jumps_ = false;
+
+        std::map<uint16_t, BasicBlock> blocks_;
+        std::map<uint16_t, Function> functions_;
+        std::vector<DataRegion> data_regions_;
+    };
+}
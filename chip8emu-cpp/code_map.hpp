@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "constants.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Tracks which bytes of memory have been translated to native code.
+    // A write to any of them means the translations are stale and must be flushed.
+    //
+    class CodeMap
+    {
+    public:
+        CodeMap() = default;
+
+        CodeMap(const CodeMap&) = delete;
+        CodeMap(CodeMap&&) = delete;
+
+        CodeMap& operator=(const CodeMap&) = delete;
+        CodeMap& operator=(CodeMap&&) = delete;
+
+        ~CodeMap() = default;
+
+        void Mark(const uint16_t address, const size_t size)
+        {
+            for (size_t i = address; i < address + size && i < kMemorySize; i++)
+            {
+                translated_[i] = true;
+            }
+        }
+
+        void Invalidate(const uint16_t address, const size_t size)
+        {
+            for (size_t i = address; i < address + size && i < kMemorySize; i++)
+            {
+                if (translated_[i])
+                {
+                    is_flush_pending_ = true;
+                    return;
+                }
+            }
+        }
+
+        bool IsFlushPending() const
+        {
+            return is_flush_pending_;
+        }
+
+        void Clear()
+        {
+            translated_.fill(false);
+            is_flush_pending_ = false;
+        }
+
+    private:
+        std::array<bool, kMemorySize> translated_{};
+        bool is_flush_pending_ = false;
+    };
+}
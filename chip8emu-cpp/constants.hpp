@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <iterator>
 #include <string>
 #include <format>
 #include <ostream>
@@ -42,12 +43,45 @@ namespace chip8_emu
     //
     constexpr uint16_t kVerticalWindowSize = kVerticalDisplaySize * kWindowZoomFactor;
 
+    //
+    // Rate at which the delay and sound timers count down, in Hz.
+    // The scheduler runs one frame per timer tick.
+    //
+    constexpr uint32_t kTimerFrequency = 60U;
+
+    //
+    // Instructions executed per frame unless configured otherwise, ~600 instructions per second.
+    //
+    constexpr uint32_t kDefaultInstructionsPerFrame = 10U;
+
+    //
+    // Longest loop, in instructions, that can be recognised as waiting for the delay timer or a key.
+    //
+    constexpr uint8_t kMaxIdleLoopLength = 8U;
+
+    //
+    // Where the machine's output goes.
+    //
+    enum class Frontend
+    {
+        // SDL window and audio device.
+        kWindowed,
+
+        // In-memory display and no audio, for turbo runs, tests and benchmarks.
+        kHeadless,
+    };
+
     //
     // Number of general purpose registers.
     // There are 16 of them. V0 -> VF.
     //
     constexpr uint8_t kNumberOfGeneralRegisters = 0x10;
 
+    //
+    // Number of keys on the hex keypad, 0 -> F.
+    //
+    constexpr uint8_t kNumberOfKeys = 0x10;
+
     //
     // Location of the sprites in memory.
     //
@@ -108,9 +142,14 @@ namespace chip8_emu
             uint8_t second_byte;
         };
 
+        OpcodeType Value() const
+        {
+            return static_cast<OpcodeType>((first_byte << 8) | second_byte);
+        }
+
         std::string ToString() const
         {
-            return std::format("{:#06x}", (first_byte << 8) | second_byte);
+            return std::format("{:#06x}", Value());
         }
     };
 
@@ -194,5 +233,68 @@ namespace chip8_emu
         kStoreBcdFromVx = 0xF033,
         kStoreRegisters = 0xF055,
         kSetRegisters = 0xF065,
+
+        // Not a CHIP-8 instruction.
+        // Every opcode that fails to decode maps to this.
+        kInvalid = 0xFFFF,
+    };
+
+    //
+    // Every instruction in declaration order.
+    // Gives each instruction a dense index that can be used for jump tables.
+    //
+    constexpr Instruction kInstructions[] =
+    {
+        Instruction::kSys,
+        Instruction::kClearScreen,
+        Instruction::kReturn,
+        Instruction::kJump,
+        Instruction::kCall,
+        Instruction::kSkipNextInstructionIfEq,
+        Instruction::kSkipNextInstructionIfNotEq,
+        Instruction::kSkipNextInstructionIfXEqY,
+        Instruction::kSetVxRegister,
+        Instruction::kAddToRegister,
+        Instruction::kSetVxVy,
+        Instruction::kOrVxVy,
+        Instruction::kAndVxVy,
+        Instruction::kXorVxVy,
+        Instruction::kAddVxVy,
+        Instruction::kSubVxVy,
+        Instruction::kShrVxVy,
+        Instruction::kSubnVxVy,
+        Instruction::kShlVxVy,
+        Instruction::kSkipNextInstructionIfXNotEqY,
+        Instruction::kSetIndexRegister,
+        Instruction::kJumpOffset,
+        Instruction::kRandom,
+        Instruction::kDraw,
+        Instruction::kSkipIfPressed,
+        Instruction::kSkipIfNotPressed,
+        Instruction::kStoreDelayTimer,
+        Instruction::kStoreKeyPress,
+        Instruction::kSetDelayTimer,
+        Instruction::kSetSoundTimer,
+        Instruction::kAddIVx,
+        Instruction::kSetSpriteFromVx,
+        Instruction::kStoreBcdFromVx,
+        Instruction::kStoreRegisters,
+        Instruction::kSetRegisters,
+        Instruction::kInvalid,
     };
+
+    constexpr uint8_t kInstructionCount = static_cast<uint8_t>(std::size(kInstructions));
+
+    constexpr uint8_t InstructionIndex(const Instruction instruction)
+    {
+        for (uint8_t i = 0; i < kInstructionCount; i++)
+        {
+            if (kInstructions[i] == instruction)
+            {
+                return i;
+            }
+        }
+
+        return kInstructionCount - 1;
+    }
 }
@@ -1,26 +1,83 @@
 #pragma once
-#include <thread>
-#include <chrono>
 
 #include <csignal>
+#include <cstring>
 #include <format>
-#include <iostream>
-#include <vector>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
-#include "display.hpp"
-#include "memory.hpp"
+#include "aot.hpp"
 #include "constants.hpp"
-#include "decoder.hpp"
-#include "keyboard.hpp"
-#include "stack.hpp"
-#include "speaker.hpp"
+#include "jit.hpp"
+#include "machine.hpp"
+#include "scheduler.hpp"
+#include "trace.hpp"
 
 namespace chip8_emu
 {
-    class Cpu
+    //
+    // Interpreter cores the CPU can execute instructions with.
+    //
+    enum class CpuCore
+    {
+        // Calls one handler per instruction through the dispatch table.
+        kHandlerTable,
+
+        // Direct-threaded code using computed goto.
+        // Every handler dispatches the next instruction itself, so each one
+        // gets its own indirect branch for the predictor to learn.
+        // Only available on GCC and Clang, falls back to kHandlerTable elsewhere.
+        kThreaded,
+
+        // Translates basic blocks to x86-64 code, see Jit.
+        // Only available on x86-64 Linux, falls back to kThreaded elsewhere.
+        kJit,
+    };
+
+    //
+    // Called by Cpu::Run before each frame, once the keyboard was polled.
+    //
+    using FrameCallback = std::function<void()>;
+
+    //
+    // Drives a Machine with one of the cores above.
+    // TracePolicy receives the pc and opcode of every executed instruction,
+    // see trace.hpp. NoTrace compiles away entirely.
+    //
+    template <typename TracePolicy = NoTrace>
+    class Cpu : public Machine
     {
     public:
-        Cpu() = default;
+        template <typename... TraceArgs>
+        explicit Cpu(const CpuCore core = CpuCore::kHandlerTable, const Frontend frontend = Frontend::kWindowed, TraceArgs&&... trace_args)
+            : Machine{ frontend }
+            , core_{ core }
+            , trace_{ std::forward<TraceArgs>(trace_args)... }
+        {
+            //
+            // Skipped iterations of idle loops would be missing from traces.
+            //
+            if constexpr (!std::is_same_v<TracePolicy, NoTrace>)
+            {
+                SetIdleLoopSkipping(false);
+            }
+
+#if defined(CHIP8_HAS_JIT)
+            //
+            // Translated blocks can't be traced instruction by instruction.
+            //
+            if constexpr (std::is_same_v<TracePolicy, NoTrace>)
+            {
+                if (core_ == CpuCore::kJit)
+                {
+                    jit_ = std::make_unique<Jit<Cpu>>(*this);
+                }
+            }
+#endif
+        }
 
         Cpu(const Cpu&) = delete;
         Cpu(Cpu&&) = delete;
@@ -30,285 +87,330 @@ namespace chip8_emu
 
         ~Cpu() = default;
 
-        void Run()
+        //
+        // Run the loaded program in real time until an opcode traps or the user quits.
+        // Emulated time only advances in whole frames, so given the same input
+        // a program always executes the same instructions between two timer ticks.
+        // The keyboard is polled once per frame, right before on_frame.
+        //
+        void Run(const uint32_t instructions_per_frame = kDefaultInstructionsPerFrame, const FrameCallback& on_frame = nullptr)
         {
-            timers_thread_ = std::thread([this]() { Timer(); });
-
-            while (true)
+            FramePacer pacer{ kTimerFrequency };
+            while (!is_trapped_ && !memory_.HasFault())
             {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                PollKeys();
+                if (on_frame)
+                {
+                    on_frame();
+                }
 
-                const Opcode opcode = memory_.FetchOpcode(registers_.pc);
-                std::cout << std::hex << opcode << std::endl;
+                RunFrame(instructions_per_frame);
+                PresentFrame();
 
-                const auto instruction = Decoder::Decode(opcode);
-                Emulate(instruction, opcode);
+                //
+                // The display backend sleeps on window events until the next frame.
+                //
+                auto& backend = display_.GetBackend();
+                if (!pacer.WaitForNextFrame([&](const auto deadline) { return backend.WaitUntil(deadline); }))
+                {
+                    return;
+                }
             }
 
-            timers_thread_.join();
+            if (memory_.HasFault())
+            {
+                throw std::runtime_error{ std::format("Memory fault: {}", memory_.GetFault().ToString()) };
+            }
+
+            throw std::runtime_error{ std::format("Invalid instruction: {}", trap_opcode_.ToString()) };
         }
 
-        void Load(const std::vector<uint8_t>& bytes)
+        //
+        // Emulate one 60Hz frame: instructions_per_frame instructions, then one timer tick.
+        // Returns how many instructions were executed.
+        //
+        uint64_t RunFrame(const uint32_t instructions_per_frame)
         {
-            memory_.Write(bytes, 0x200);
+            const auto executed = Execute(instructions_per_frame);
+            TickTimers();
 
-            //
-            // CHIP-8 programs are usually loaded at 0x200
-            //
-            registers_.pc = 0x200;
+            return executed;
         }
 
-    private:
-        void Timer()
+        //
+        // Run the blocks of a program compiled by chip8-aot wherever pc reaches one,
+        // see Aot. Everything else is interpreted.
+        //
+        void UseCompiledProgram(const CompiledProgram<Cpu>& program)
         {
-            while (true)
-            {
-                if (registers_.delay_timer != 0)
-                {
-                    registers_.delay_timer -= 1;
-                }
+#if defined(CHIP8_HAS_JIT)
+            jit_.reset();
+#endif
+            aot_ = std::make_unique<Aot<Cpu>>(*this, program);
+        }
 
-                if (registers_.sound_timer != 0)
-                {
-                    registers_.sound_timer -= 1;
-                    speaker_.Play(true);
-                }
-                else
+        //
+        // Execute up to budget instructions on the selected core.
+        // Returns how many were executed, fewer than budget only if an opcode trapped
+        // or FX0A is waiting for a key. Skipped iterations of idle loops count as executed.
+        //
+        uint64_t Execute(const uint64_t budget)
+        {
+            uint64_t executed = 0;
+            do
+            {
+                executed += ExecuteCore(budget - executed);
+                if (is_idle_)
                 {
-                    speaker_.Play(false);
+                    executed += SkipIdleLoop(budget - executed);
                 }
+            } while (executed < budget && !IsStopped());
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(16));
-            }
+            return executed;
         }
 
-        void Emulate(const Instruction instruction, const Opcode opcode)
+    private:
+        friend class Jit<Cpu>;
+        friend class Aot<Cpu>;
+
+        uint64_t ExecuteCore(const uint64_t budget)
         {
-            switch (instruction)
+            if (aot_ != nullptr)
             {
-            case Instruction::kReturn:
-                registers_.pc = stack_.pop();
-                break;
-            case Instruction::kClearScreen:
-                display_.Clear();
-                display_.Refresh();
-                break;
-            case Instruction::kJump:
-                registers_.pc = (opcode.nib1 << 8) | opcode.second_byte;
-                break;
-            case Instruction::kCall:
-                stack_.push(registers_.pc);
-                registers_.pc = (opcode.nib1 << 8) | opcode.second_byte;
-            case Instruction::kSetVxRegister:
+                return aot_->Execute(budget);
+            }
+
+#if defined(CHIP8_HAS_JIT)
+            if (jit_ != nullptr)
             {
-                registers_.v[opcode.nib1] = opcode.second_byte;
-                break;
+                return jit_->Execute(budget);
             }
-            case Instruction::kAddToRegister:
+#endif
+#if defined(__GNUC__)
+            if (core_ == CpuCore::kThreaded || core_ == CpuCore::kJit)
             {
-                registers_.v[opcode.nib1] += opcode.second_byte;
-                break;
+                return ExecuteThreaded(budget);
             }
-            case Instruction::kSetVxVy:
-                registers_.v[opcode.nib1] = registers_.v[opcode.nib2];
-                break;
-            case Instruction::kOrVxVy:
-                registers_.v[opcode.nib1] |= registers_.v[opcode.nib2];
-                break;
-            case Instruction::kAndVxVy:
-                registers_.v[opcode.nib1] &= registers_.v[opcode.nib2];
-                break;
-            case Instruction::kXorVxVy:
-                registers_.v[opcode.nib1] ^= registers_.v[opcode.nib2];
-                break;
-            case Instruction::kAddVxVy:
-                if ((registers_.v[opcode.nib1] + registers_.v[opcode.nib2]) > 255)
-                {
-                    registers_.v[0xF] = 0x1;
-                }
-                else
-                {
-                    registers_.v[0xF] = 0x0;
-                }
-
-                registers_.v[opcode.nib1] += registers_.v[opcode.nib2];
-                break;
-            case Instruction::kSubVxVy:
-                if (registers_.v[opcode.nib1] >= registers_.v[opcode.nib2])
-                {
-                    registers_.v[0xF] = 0x1;
-                }
-                else
-                {
-                    registers_.v[0xF] = 0x0;
-                }
+#endif
+            return ExecuteHandlers(budget);
+        }
 
-                registers_.v[opcode.nib1] = registers_.v[opcode.nib1] - registers_.v[opcode.nib2];
-                break;
-            case Instruction::kSubnVxVy:
-                if (registers_.v[opcode.nib2] >= registers_.v[opcode.nib1])
-                {
-                    registers_.v[0xF] = 0x1;
-                }
-                else
+        //
+        // A jump stopped the core at the start of what might be an idle loop.
+        // Run one more iteration: if it only compared, read the delay timer or keys
+        // and jumped back, and left the registers exactly as they were, every
+        // iteration does the same until the timers tick or the keys change between
+        // frames. Skip as many whole iterations as fit in budget, so whatever runs
+        // next starts at the same point of the loop as it would have.
+        // The JIT translates jumps itself, so this only happens on the other cores.
+        //
+        uint64_t SkipIdleLoop(const uint64_t budget)
+        {
+            const auto start = registers_;
+            bool is_idle = true;
+            uint64_t length = 0;
+            do
+            {
+                is_idle_ = false;
+                if (length == budget || IsStopped())
                 {
-                    registers_.v[0xF] = 0x0;
+                    return length;
                 }
 
-                registers_.v[opcode.nib1] = registers_.v[opcode.nib2] - registers_.v[opcode.nib1];
-                break;
-            case Instruction::kShrVxVy:
-                if (registers_.v[opcode.nib1] & 0x1)
-                {
-                    registers_.v[0xF] = 0x1;
-                }
-                else
-                {
-                    registers_.v[0xF] = 0x0;
-                }
+                const auto pc = registers_.pc;
+                const auto& decoded = Fetch();
+                trace_.Record(pc, decoded.opcode);
 
-                registers_.v[opcode.nib1] >>= 1;
-                break;
-            case Instruction::kShlVxVy:
-                if (registers_.v[opcode.nib1] & 0x80)
-                {
-                    registers_.v[0xF] = 0x1;
-                }
-                else
-                {
-                    registers_.v[0xF] = 0x0;
-                }
+                is_idle = is_idle && IsIdleLoopInstruction(decoded.instruction);
+                decoded.handler(*this, decoded);
+                length++;
+            } while (registers_.pc != start.pc && length < kMaxIdleLoopLength);
 
-                registers_.v[opcode.nib1] <<= 1;
-                break;
-            case Instruction::kSetIndexRegister:
-                registers_.index = (opcode.nib1 << 8) | opcode.second_byte;
-                break;
-            case Instruction::kJumpOffset:
-                registers_.pc = ((opcode.nib1 << 8) | opcode.second_byte) + registers_.v[0];
-                break;
-            case Instruction::kRandom:
-                registers_.v[opcode.nib1] = std::rand() & opcode.second_byte;
-                break;
-            case Instruction::kDraw:
+            //
+            // The jump back flagged the loop again, this is the check.
+            //
+            is_idle_ = false;
+            if (!is_idle || std::memcmp(&registers_, &start, sizeof(start)) != 0)
             {
-                const uint8_t x = opcode.nib1;
-                const uint8_t y = opcode.nib2;
-                const uint8_t n = opcode.nib3;
-                
-                const uint8_t* sprite = static_cast<uint8_t*>(memory_.Data(registers_.index));
-                const auto pixel_turned_off = display_.Draw(registers_.v[x], registers_.v[y], sprite, n);
-                display_.Refresh();
+                return length;
+            }
 
-                registers_.v[0xF] = pixel_turned_off ? 0x1 : 0x0;
+            return length + (budget - length) / length * length;
+        }
 
-                break;
-            }
-            case Instruction::kSkipNextInstructionIfEq:
-                if (registers_.v[opcode.nib1] == opcode.second_byte)
-                {
-                    registers_.pc += 2;
-                }
-                break;
-            case Instruction::kSkipNextInstructionIfNotEq:
-                if (registers_.v[opcode.nib1] != opcode.second_byte)
-                {
-                    registers_.pc += 2;
-                }
-                break;
-            case Instruction::kSkipNextInstructionIfXEqY:
-                if (registers_.v[opcode.nib1] == registers_.v[opcode.nib2])
-                {
-                    registers_.pc += 2;
-                }
-                break;
-            case Instruction::kSkipNextInstructionIfXNotEqY:
-                if (registers_.v[opcode.nib1] != registers_.v[opcode.nib2])
-                {
-                    registers_.pc += 2;
-                }
-                break;
-            case Instruction::kSkipIfPressed:
-            {
-                const auto key = registers_.v[opcode.nib1];
-                if (keyboard_.IsKeyPressed(key))
-                {
-                    registers_.pc += 2;
-                }
-                break;
-            }
-            case Instruction::kSkipIfNotPressed:
+        uint64_t ExecuteHandlers(const uint64_t budget)
+        {
+            uint64_t executed = 0;
+            while (executed < budget && !IsStopped())
             {
-                const auto key = registers_.v[opcode.nib1];
-                if (!keyboard_.IsKeyPressed(key))
-                {
-                    registers_.pc += 2;
-                }
-                break;
+                const auto pc = registers_.pc;
+                const auto& decoded = Fetch();
+                trace_.Record(pc, decoded.opcode);
+
+                decoded.handler(*this, decoded);
+                executed++;
             }
-            case Instruction::kStoreDelayTimer:
-                registers_.v[opcode.nib1] = registers_.delay_timer;
-                break;
-            case Instruction::kStoreKeyPress:
-                registers_.v[opcode.nib1] = keyboard_.WaitForKeyPress();
-                break;
-            case Instruction::kSetDelayTimer:
-                registers_.delay_timer = registers_.v[opcode.nib1];
-                break;
-            case Instruction::kSetSoundTimer:
-                registers_.sound_timer = registers_.v[opcode.nib1];
-                break;
-            case Instruction::kAddIVx:
-                registers_.index = registers_.index + registers_.v[opcode.nib1];
-            case Instruction::kSetSpriteFromVx:
-                registers_.index = kSpritesAddress + kSpriteSize * opcode.nib1;
-                break;
-            case Instruction::kStoreBcdFromVx:
+
+            return executed;
+        }
+
+#if defined(__GNUC__)
+        uint64_t ExecuteThreaded(const uint64_t budget)
+        {
+            //
+            // Same order as kInstructions, indexed by DecodedInstruction::index.
+            //
+            static void* const kLabels[] =
             {
-                uint8_t dec = 0;
-                const auto address = registers_.index;
+                &&kSys,
+                &&kClearScreen,
+                &&kReturn,
+                &&kJump,
+                &&kCall,
+                &&kSkipNextInstructionIfEq,
+                &&kSkipNextInstructionIfNotEq,
+                &&kSkipNextInstructionIfXEqY,
+                &&kSetVxRegister,
+                &&kAddToRegister,
+                &&kSetVxVy,
+                &&kOrVxVy,
+                &&kAndVxVy,
+                &&kXorVxVy,
+                &&kAddVxVy,
+                &&kSubVxVy,
+                &&kShrVxVy,
+                &&kSubnVxVy,
+                &&kShlVxVy,
+                &&kSkipNextInstructionIfXNotEqY,
+                &&kSetIndexRegister,
+                &&kJumpOffset,
+                &&kRandom,
+                &&kDraw,
+                &&kSkipIfPressed,
+                &&kSkipIfNotPressed,
+                &&kStoreDelayTimer,
+                &&kStoreKeyPress,
+                &&kSetDelayTimer,
+                &&kSetSoundTimer,
+                &&kAddIVx,
+                &&kSetSpriteFromVx,
+                &&kStoreBcdFromVx,
+                &&kStoreRegisters,
+                &&kSetRegisters,
+                &&kInvalid,
+            };
+            static_assert(std::size(kLabels) == kInstructionCount);
 
-                dec = registers_.v[opcode.nib1] / 100;
-                memory_.Write(dec, address);
+            uint64_t executed = 0;
+            const DecodedInstruction* decoded = nullptr;
 
-                dec = registers_.v[opcode.nib1] / 10 % 10;
-                memory_.Write(dec, address + 1);
+            //
+            // Only kSys and kInvalid can trap, only kStoreKeyPress can wait, only
+            // kJump can close an idle loop and only the handlers touching memory
+            // can fault, so they're the only ones that need to check for it.
+            // The fault check compiles away unless memory is checked.
+            //
+#define CHIP8_DISPATCH()                            \
+            if (executed == budget)                 \
+            {                                       \
+                return executed;                    \
+            }                                       \
+            decoded = &Fetch();                     \
+            trace_.Record(static_cast<uint16_t>(registers_.pc - 2), decoded->opcode); \
+            executed++;                             \
+            goto *kLabels[decoded->index]
 
-                dec = registers_.v[opcode.nib1] % 10;
-                memory_.Write(dec, address + 2);
-                break;
-            }
-            case Instruction::kStoreRegisters:
+#define CHIP8_HANDLER(name)                         \
+        name:                                       \
+            Emulate<Instruction::name>(*decoded);   \
+            CHIP8_DISPATCH()
+
+#define CHIP8_MEMORY_HANDLER(name)                  \
+        name:                                       \
+            Emulate<Instruction::name>(*decoded);   \
+            if (memory_.HasFault())                 \
+            {                                       \
+                return executed;                    \
+            }                                       \
+            CHIP8_DISPATCH()
+
+            if (IsStopped())
             {
-                const auto address = registers_.index;
-                for (uint8_t i = 0; i <= opcode.nib1; i++)
-                {
-                    memory_.Write(registers_.v[i], address + i);
-                }
-                break;
+                return 0;
             }
-            case Instruction::kSetRegisters:
+
+            CHIP8_DISPATCH();
+
+            CHIP8_HANDLER(kClearScreen);
+            CHIP8_HANDLER(kReturn);
+            CHIP8_HANDLER(kCall);
+            CHIP8_HANDLER(kSkipNextInstructionIfEq);
+            CHIP8_HANDLER(kSkipNextInstructionIfNotEq);
+            CHIP8_HANDLER(kSkipNextInstructionIfXEqY);
+            CHIP8_HANDLER(kSetVxRegister);
+            CHIP8_HANDLER(kAddToRegister);
+            CHIP8_HANDLER(kSetVxVy);
+            CHIP8_HANDLER(kOrVxVy);
+            CHIP8_HANDLER(kAndVxVy);
+            CHIP8_HANDLER(kXorVxVy);
+            CHIP8_HANDLER(kAddVxVy);
+            CHIP8_HANDLER(kSubVxVy);
+            CHIP8_HANDLER(kShrVxVy);
+            CHIP8_HANDLER(kSubnVxVy);
+            CHIP8_HANDLER(kShlVxVy);
+            CHIP8_HANDLER(kSkipNextInstructionIfXNotEqY);
+            CHIP8_HANDLER(kSetIndexRegister);
+            CHIP8_HANDLER(kJumpOffset);
+            CHIP8_HANDLER(kRandom);
+            CHIP8_MEMORY_HANDLER(kDraw);
+            CHIP8_HANDLER(kSkipIfPressed);
+            CHIP8_HANDLER(kSkipIfNotPressed);
+            CHIP8_HANDLER(kStoreDelayTimer);
+            CHIP8_HANDLER(kSetDelayTimer);
+            CHIP8_HANDLER(kSetSoundTimer);
+            CHIP8_HANDLER(kAddIVx);
+            CHIP8_HANDLER(kSetSpriteFromVx);
+            CHIP8_MEMORY_HANDLER(kStoreBcdFromVx);
+            CHIP8_MEMORY_HANDLER(kStoreRegisters);
+            CHIP8_MEMORY_HANDLER(kSetRegisters);
+
+        kStoreKeyPress:
+            Emulate<Instruction::kStoreKeyPress>(*decoded);
+            if (is_waiting_for_key_)
             {
-                const auto address = registers_.index;
-                for (uint8_t i = 0; i <= opcode.nib1; i++)
-                {
-                    registers_.v[i] = memory_.Read(address + i);
-                }
-                break;
+                return executed;
             }
-            default:
-                throw std::runtime_error{ std::format("Instruction {} not implemented", opcode.ToString()) };
+            CHIP8_DISPATCH();
+
+        kJump:
+            Emulate<Instruction::kJump>(*decoded);
+            if (is_idle_)
+            {
+                return executed;
             }
+            CHIP8_DISPATCH();
+
+        kSys:
+            Emulate<Instruction::kSys>(*decoded);
+            return executed;
+
+        kInvalid:
+            Emulate<Instruction::kInvalid>(*decoded);
+            return executed;
+
+#undef CHIP8_MEMORY_HANDLER
+#undef CHIP8_HANDLER
+#undef CHIP8_DISPATCH
         }
+#endif
 
-        Registers registers_{ 0x00 };
-        Stack stack_;
-        Memory memory_;
-        Display display_;
-        Keyboard keyboard_;
-        Speaker speaker_;
+        CpuCore core_;
+        TracePolicy trace_;
+        std::unique_ptr<Aot<Cpu>> aot_;
 
-        std::thread timers_thread_;
+#if defined(CHIP8_HAS_JIT)
+        std::unique_ptr<Jit<Cpu>> jit_;
+#endif
     };
 
-}
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "constants.hpp"
+#include "decoder.hpp"
+
+namespace chip8_emu
+{
+    class Machine;
+    struct DecodedInstruction;
+
+    //
+    // Executes a single decoded instruction.
+    //
+    using InstructionHandler = void (*)(Machine&, const DecodedInstruction&);
+
+    //
+    // Everything known about an opcode before looking at its operands,
+    // one entry per opcode in Machine's dispatch table.
+    //
+    struct DispatchEntry
+    {
+        InstructionHandler handler;
+        Instruction instruction;
+        uint8_t index;
+    };
+
+    //
+    // An instruction together with every operand the handlers might need,
+    // extracted once from the raw opcode.
+    //
+    struct DecodedInstruction
+    {
+        // Handler executing this instruction, taken from the dispatch table
+        InstructionHandler handler;
+
+        // Decoded instruction type
+        Instruction instruction;
+
+        // Dense index of the instruction in kInstructions
+        uint8_t index;
+
+        // Raw opcode, kept around for tracing and error messages
+        Opcode opcode;
+
+        // Register operands, 0x0X00 and 0x00Y0
+        uint8_t x;
+        uint8_t y;
+
+        // Lowest nibble, 0x000N
+        uint8_t n;
+
+        // Lowest byte, 0x00NN
+        uint8_t nn;
+
+        // Lowest 12 bits, 0x0NNN. Usually an address.
+        uint16_t nnn;
+
+        static DecodedInstruction From(const Opcode opcode, const DispatchEntry& entry)
+        {
+            DecodedInstruction decoded;
+
+            decoded.handler = entry.handler;
+            decoded.instruction = entry.instruction;
+            decoded.index = entry.index;
+            decoded.opcode = opcode;
+            decoded.x = opcode.nib1;
+            decoded.y = opcode.nib2;
+            decoded.n = opcode.nib3;
+            decoded.nn = opcode.second_byte;
+            decoded.nnn = static_cast<uint16_t>((opcode.nib1 << 8) | opcode.second_byte);
+
+            return decoded;
+        }
+    };
+
+    //
+    // Caches decoded instructions, one entry for every even address in memory.
+    // Entries are filled lazily the first time the CPU executes them and are
+    // invalidated by Memory whenever one of their bytes is written.
+    //
+    class DecodeCache
+    {
+    public:
+        static constexpr uint16_t kEntryCount = kMemorySize / 2;
+
+        DecodeCache() = default;
+
+        DecodeCache(const DecodeCache&) = delete;
+        DecodeCache(DecodeCache&&) = delete;
+
+        DecodeCache& operator=(const DecodeCache&) = delete;
+        DecodeCache& operator=(DecodeCache&&) = delete;
+
+        ~DecodeCache() = default;
+
+        //
+        // Returns the cached instruction at pc, or nullptr if it has to be decoded.
+        // Instructions at odd addresses are never cached.
+        //
+        const DecodedInstruction* Find(const uint16_t pc) const
+        {
+            if ((pc & 0x1) || pc >= kMemorySize || !valid_[pc >> 1])
+            {
+                return nullptr;
+            }
+
+            return &entries_[pc >> 1];
+        }
+
+        const DecodedInstruction& Insert(const uint16_t pc, const DecodedInstruction& decoded)
+        {
+            if ((pc & 0x1) || pc >= kMemorySize)
+            {
+                //
+                // Jumping to an odd address is legal but rare.
+                // Hand back a scratch slot instead of polluting the cache.
+                //
+                uncached_ = decoded;
+                return uncached_;
+            }
+
+            entries_[pc >> 1] = decoded;
+            valid_[pc >> 1] = true;
+
+            return entries_[pc >> 1];
+        }
+
+        //
+        // Drop every entry whose opcode overlaps [address, address + size).
+        //
+        void Invalidate(const uint16_t address, const size_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+
+            const size_t first = address >> 1;
+            const size_t last = (address + size - 1) >> 1;
+            for (auto i = first; i <= last && i < kEntryCount; i++)
+            {
+                valid_[i] = false;
+            }
+        }
+
+        void Clear()
+        {
+            valid_.fill(false);
+        }
+
+    private:
+        std::array<DecodedInstruction, kEntryCount> entries_{};
+        std::array<bool, kEntryCount> valid_{};
+
+        //
+        // Holds the last instruction decoded at an odd address.
+        //
+        DecodedInstruction uncached_{};
+    };
+}
@@ -1,18 +1,28 @@
 #pragma once
 
 #include <format>
-#include <stdexcept>
+#include <string>
 
 #include "constants.hpp"
 
 namespace chip8_emu
 {
+    //
+    // Decoding never throws. Opcodes that don't map to a CHIP-8 instruction
+    // decode to Instruction::kInvalid and it's up to the caller to trap them.
+    // Everything is constexpr so dispatch tables can be generated at compile time.
+    //
     class Decoder
     {
     public:
-        static Instruction Decode(Opcode opcode)
+        static Instruction Decode(const Opcode opcode)
         {
-            switch (opcode.nib0)
+            return Decode(opcode.Value());
+        }
+
+        static constexpr Instruction Decode(const OpcodeType opcode)
+        {
+            switch (opcode >> 12)
             {
             case 0x0:
                 return DecodeNibble0X0(opcode);
@@ -47,14 +57,103 @@ namespace chip8_emu
             case 0xF:
                 return DecodeNibble0XF(opcode);
             default:
-                throw std::runtime_error{ std::format("Unknown instruction: {}", opcode.ToString()) };
+                return Instruction::kInvalid;
+            }
+        }
+
+        //
+        // Assembly for an opcode, in the usual CHIP-8 mnemonics.
+        // Opcodes that don't decode are shown as a data word.
+        //
+        static std::string Disassemble(const Opcode opcode)
+        {
+            const auto x = opcode.nib1;
+            const auto y = opcode.nib2;
+            const auto n = opcode.nib3;
+            const auto nn = opcode.second_byte;
+            const auto nnn = opcode.Value() & 0xFFF;
+
+            switch (Decode(opcode))
+            {
+            case Instruction::kSys:
+                return std::format("SYS {:#05x}", nnn);
+            case Instruction::kClearScreen:
+                return "CLS";
+            case Instruction::kReturn:
+                return "RET";
+            case Instruction::kJump:
+                return std::format("JP {:#05x}", nnn);
+            case Instruction::kCall:
+                return std::format("CALL {:#05x}", nnn);
+            case Instruction::kSkipNextInstructionIfEq:
+                return std::format("SE V{:X}, {:#04x}", x, nn);
+            case Instruction::kSkipNextInstructionIfNotEq:
+                return std::format("SNE V{:X}, {:#04x}", x, nn);
+            case Instruction::kSkipNextInstructionIfXEqY:
+                return std::format("SE V{:X}, V{:X}", x, y);
+            case Instruction::kSetVxRegister:
+                return std::format("LD V{:X}, {:#04x}", x, nn);
+            case Instruction::kAddToRegister:
+                return std::format("ADD V{:X}, {:#04x}", x, nn);
+            case Instruction::kSetVxVy:
+                return std::format("LD V{:X}, V{:X}", x, y);
+            case Instruction::kOrVxVy:
+                return std::format("OR V{:X}, V{:X}", x, y);
+            case Instruction::kAndVxVy:
+                return std::format("AND V{:X}, V{:X}", x, y);
+            case Instruction::kXorVxVy:
+                return std::format("XOR V{:X}, V{:X}", x, y);
+            case Instruction::kAddVxVy:
+                return std::format("ADD V{:X}, V{:X}", x, y);
+            case Instruction::kSubVxVy:
+                return std::format("SUB V{:X}, V{:X}", x, y);
+            case Instruction::kShrVxVy:
+                return std::format("SHR V{:X}, V{:X}", x, y);
+            case Instruction::kSubnVxVy:
+                return std::format("SUBN V{:X}, V{:X}", x, y);
+            case Instruction::kShlVxVy:
+                return std::format("SHL V{:X}, V{:X}", x, y);
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+                return std::format("SNE V{:X}, V{:X}", x, y);
+            case Instruction::kSetIndexRegister:
+                return std::format("LD I, {:#05x}", nnn);
+            case Instruction::kJumpOffset:
+                return std::format("JP V0, {:#05x}", nnn);
+            case Instruction::kRandom:
+                return std::format("RND V{:X}, {:#04x}", x, nn);
+            case Instruction::kDraw:
+                return std::format("DRW V{:X}, V{:X}, {}", x, y, n);
+            case Instruction::kSkipIfPressed:
+                return std::format("SKP V{:X}", x);
+            case Instruction::kSkipIfNotPressed:
+                return std::format("SKNP V{:X}", x);
+            case Instruction::kStoreDelayTimer:
+                return std::format("LD V{:X}, DT", x);
+            case Instruction::kStoreKeyPress:
+                return std::format("LD V{:X}, K", x);
+            case Instruction::kSetDelayTimer:
+                return std::format("LD DT, V{:X}", x);
+            case Instruction::kSetSoundTimer:
+                return std::format("LD ST, V{:X}", x);
+            case Instruction::kAddIVx:
+                return std::format("ADD I, V{:X}", x);
+            case Instruction::kSetSpriteFromVx:
+                return std::format("LD F, V{:X}", x);
+            case Instruction::kStoreBcdFromVx:
+                return std::format("LD B, V{:X}", x);
+            case Instruction::kStoreRegisters:
+                return std::format("LD [I], V{:X}", x);
+            case Instruction::kSetRegisters:
+                return std::format("LD V{:X}, [I]", x);
+            default:
+                return std::format("DW {:#06x}", opcode.Value());
             }
         }
 
     private:
-        static Instruction DecodeNibble0X0(const Opcode opcode)
+        static constexpr Instruction DecodeNibble0X0(const OpcodeType opcode)
         {
-            switch (opcode.second_byte)
+            switch (opcode & 0xFF)
             {
             case 0xE0:
                 return Instruction::kClearScreen;
@@ -63,13 +162,13 @@ namespace chip8_emu
             case 0x00:
                 return Instruction::kSys;
             default:
-                throw std::runtime_error{ std::format("Invalid instruction: {}", opcode.ToString()) };
+                return Instruction::kInvalid;
             }
         }
 
-        static Instruction DecodeNibble0X8(Opcode opcode)
+        static constexpr Instruction DecodeNibble0X8(const OpcodeType opcode)
         {
-            switch (opcode.nib3)
+            switch (opcode & 0xF)
             {
             case 0x0:
                 return Instruction::kSetVxVy;
@@ -90,26 +189,26 @@ namespace chip8_emu
             case 0xE:
                 return Instruction::kShlVxVy;
             default:
-                throw std::runtime_error{ std::format("Invalid instruction: {}", opcode.ToString()) };
+                return Instruction::kInvalid;
             }
         }
 
-        static Instruction DecodeNibble0XE(Opcode opcode)
+        static constexpr Instruction DecodeNibble0XE(const OpcodeType opcode)
         {
-            switch (opcode.second_byte)
+            switch (opcode & 0xFF)
             {
             case 0x9E:
                 return Instruction::kSkipIfPressed;
             case 0xA1:
                 return Instruction::kSkipIfNotPressed;
             default:
-                throw std::runtime_error{ std::format("Invalid instruction: {}", opcode.ToString()) };
+                return Instruction::kInvalid;
             }
         }
 
-        static Instruction DecodeNibble0XF(Opcode opcode)
+        static constexpr Instruction DecodeNibble0XF(const OpcodeType opcode)
         {
-            switch (opcode.second_byte)
+            switch (opcode & 0xFF)
             {
             case 0x07:
                 return Instruction::kStoreDelayTimer;
@@ -130,7 +229,7 @@ namespace chip8_emu
             case 0x65:
                 return Instruction::kSetRegisters;
             default:
-                throw std::runtime_error{ std::format("Invalid instruction: {}", opcode.ToString()) };
+                return Instruction::kInvalid;
             }
         }
     };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "framebuffer.hpp"
+#include "scheduler.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Where Display sends finished frames.
+    //
+    class DisplayBackend
+    {
+    public:
+        virtual ~DisplayBackend() = default;
+
+        //
+        // Called at most once per frame, when the program changed the screen.
+        //
+        virtual void Present(const Framebuffer& frame) = 0;
+
+        //
+        // Block until deadline, handling whatever events the frontend has meanwhile.
+        // Returns false once the user asked to quit.
+        //
+        virtual bool WaitUntil(const std::chrono::steady_clock::time_point deadline)
+        {
+            FramePacer::SleepUntil(deadline);
+            return true;
+        }
+    };
+
+    //
+    // Keeps frames in memory only, never touches SDL.
+    // Lets any number of machines run without a desktop session.
+    //
+    class HeadlessDisplayBackend : public DisplayBackend
+    {
+    public:
+        void Present(const Framebuffer&) override
+        {
+            frames_presented_++;
+        }
+
+        uint64_t GetFramesPresented() const
+        {
+            return frames_presented_;
+        }
+
+    private:
+        uint64_t frames_presented_ = 0;
+    };
+}
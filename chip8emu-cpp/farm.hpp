@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "constants.hpp"
+#include "cpu.hpp"
+#include "thread_pool.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Why a Farm instance stopped.
+    //
+    enum class ExitReason
+    {
+        // Ran every requested frame.
+        kFrameLimit,
+
+        // Hit an invalid or unimplemented opcode.
+        kTrapped,
+
+        // An instruction threw or accessed memory out of bounds, see FarmResult::error.
+        kError,
+
+        // FX0A is waiting for a key with both timers expired. There's no input
+        // to wake it up, so it's parked instead of running empty frames.
+        kWaitingForKey,
+    };
+
+    struct FarmResult
+    {
+        uint64_t framebuffer_hash = 0;
+        uint64_t instructions = 0;
+        uint64_t frames = 0;
+        ExitReason exit_reason = ExitReason::kFrameLimit;
+        std::string error;
+    };
+
+    //
+    // Runs one ROM on many independent headless machines, one per seed.
+    // Instances share nothing but the ROM bytes, so they scale with the
+    // number of cores of the work-stealing pool.
+    //
+    class Farm
+    {
+    public:
+        Farm(
+            const std::vector<uint8_t>& rom,
+            const std::vector<uint32_t>& seeds,
+            const CpuCore core = CpuCore::kHandlerTable,
+            const uint32_t instructions_per_frame = kDefaultInstructionsPerFrame,
+            const size_t thread_count = std::thread::hardware_concurrency())
+            : instructions_per_frame_{ instructions_per_frame }
+            , pool_{ thread_count }
+            , results_(seeds.size())
+        {
+            for (const auto seed : seeds)
+            {
+                auto& cpu = instances_.emplace_back(std::make_unique<Cpu<>>(core, Frontend::kHeadless));
+                cpu->Seed(seed);
+                cpu->Load(rom);
+            }
+        }
+
+        Farm(const Farm&) = delete;
+        Farm(Farm&&) = delete;
+
+        Farm& operator=(const Farm&) = delete;
+        Farm& operator=(Farm&&) = delete;
+
+        ~Farm() = default;
+
+        size_t GetInstanceCount() const
+        {
+            return instances_.size();
+        }
+
+        Cpu<>& GetInstance(const size_t index)
+        {
+            return *instances_[index];
+        }
+
+        //
+        // Advance every instance that is still running by up to frames frames.
+        // Can be called repeatedly, results accumulate.
+        //
+        const std::vector<FarmResult>& Run(const uint64_t frames)
+        {
+            pool_.ParallelFor(instances_.size(), [this, frames](const size_t index) { RunInstance(index, frames); });
+            return results_;
+        }
+
+        const std::vector<FarmResult>& GetResults() const
+        {
+            return results_;
+        }
+
+    private:
+        void RunInstance(const size_t index, const uint64_t frames)
+        {
+            auto& cpu = *instances_[index];
+            auto& result = results_[index];
+            if (result.exit_reason != ExitReason::kFrameLimit)
+            {
+                return;
+            }
+
+            try
+            {
+                for (uint64_t frame = 0; frame < frames && !cpu.IsTrapped() && !cpu.IsParked() && !cpu.GetMemory().HasFault(); frame++)
+                {
+                    result.instructions += cpu.RunFrame(instructions_per_frame_);
+                    result.frames++;
+                }
+            }
+            catch (const std::exception& e)
+            {
+                result.exit_reason = ExitReason::kError;
+                result.error = e.what();
+            }
+
+            //
+            // Reported like Batch does, as an error.
+            //
+            if (cpu.GetMemory().HasFault())
+            {
+                result.exit_reason = ExitReason::kError;
+                result.error = std::format("Memory fault: {}", cpu.GetMemory().GetFault().ToString());
+            }
+            else if (cpu.IsTrapped())
+            {
+                result.exit_reason = ExitReason::kTrapped;
+            }
+            else if (cpu.IsParked())
+            {
+                result.exit_reason = ExitReason::kWaitingForKey;
+            }
+
+            result.framebuffer_hash = cpu.GetFramebuffer().Hash();
+        }
+
+        uint32_t instructions_per_frame_;
+        WorkStealingPool pool_;
+        std::vector<std::unique_ptr<Cpu<>>> instances_;
+        std::vector<FarmResult> results_;
+    };
+}
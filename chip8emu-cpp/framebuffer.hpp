@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "constants.hpp"
+#include "savestate.hpp"
+
+namespace chip8_emu
+{
+    //
+    // CHIP-8 pixel data, 64x32 monochrome pixels.
+    // Each row is packed into a 64-bit word, the most significant bit is x = 0.
+    //
+    class Framebuffer
+    {
+    public:
+        void Clear()
+        {
+            rows_.fill(0);
+            is_dirty_ = true;
+        }
+
+        bool Draw(uint16_t x, uint16_t y, const uint8_t *sprite, const uint8_t sprite_size)
+        {
+            //
+            // Make sure coords are within bounds.
+            //
+            x = x % kHorizontalDisplaySize;
+            y = y % kVerticalDisplaySize;
+
+            //
+            // Each sprite byte is a line of 8 pixels. Line it up with x inside a row,
+            // pixels shifted out past the right border are clipped.
+            // If we reach the bottom screen border stop drawing.
+            // Any pixel that is on in both the row and the sprite is turned off,
+            // which the caller reports through VF.
+            //
+            is_dirty_ = true;
+
+            uint64_t turned_off = 0;
+            for (auto i = 0U; i < sprite_size && y < kVerticalDisplaySize; i++, y++)
+            {
+                const uint64_t mask = (static_cast<uint64_t>(sprite[i]) << 56) >> x;
+                turned_off |= rows_[y] & mask;
+                rows_[y] ^= mask;
+            }
+
+            return turned_off != 0;
+        }
+
+        bool IsPixelOn(const uint8_t x, const uint8_t y) const
+        {
+            return (rows_[y] >> (kHorizontalDisplaySize - 1 - x)) & 1;
+        }
+
+        //
+        // Set by every Clear and Draw since the last ClearDirty.
+        //
+        bool IsDirty() const
+        {
+            return is_dirty_;
+        }
+
+        void ClearDirty()
+        {
+            is_dirty_ = false;
+        }
+
+        uint64_t GetRow(const uint8_t y) const
+        {
+            return rows_[y];
+        }
+
+        //
+        // FNV-1a over the rows, for comparing screens without keeping them around.
+        //
+        uint64_t Hash() const
+        {
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            for (const auto row : rows_)
+            {
+                for (int shift = 56; shift >= 0; shift -= 8)
+                {
+                    hash ^= (row >> shift) & 0xFF;
+                    hash *= 0x100000001B3ULL;
+                }
+            }
+
+            return hash;
+        }
+
+        void SaveState(StateWriter& writer) const
+        {
+            for (const auto row : rows_)
+            {
+                writer.WriteU64(row);
+            }
+        }
+
+        void LoadState(StateReader& reader)
+        {
+            for (auto& row : rows_)
+            {
+                row = reader.ReadU64();
+            }
+            is_dirty_ = true;
+        }
+
+    private:
+        static_assert(kHorizontalDisplaySize == 64, "A row must fit exactly in a uint64_t");
+
+        std::array<uint64_t, kVerticalDisplaySize> rows_{};
+        bool is_dirty_ = false;
+    };
+}
@@ -0,0 +1,870 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "constants.hpp"
+#include "code_map.hpp"
+#include "decode_cache.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define CHIP8_HAS_JIT 1
+#include <sys/mman.h>
+#endif
+
+namespace chip8_emu
+{
+    template <typename CpuType>
+    class Jit;
+
+#if defined(CHIP8_HAS_JIT)
+    //
+    // Writes x86-64 machine code into a buffer.
+    // Only knows the handful of encodings the JIT needs. Memory operands are
+    // always [rbx + disp8], rbx pointing at the CHIP-8 Registers.
+    //
+    class X64Emitter
+    {
+    public:
+        explicit X64Emitter(uint8_t* code)
+            : code_{ code }
+        {
+        }
+
+        uint8_t* Position() const
+        {
+            return code_;
+        }
+
+        void Byte(const uint8_t byte)
+        {
+            *code_++ = byte;
+        }
+
+        template <typename... Values>
+        void Bytes(const Values... bytes)
+        {
+            (Byte(static_cast<uint8_t>(bytes)), ...);
+        }
+
+        void Imm16(const uint16_t value)
+        {
+            std::memcpy(code_, &value, sizeof(value));
+            code_ += sizeof(value);
+        }
+
+        void Imm32(const uint32_t value)
+        {
+            std::memcpy(code_, &value, sizeof(value));
+            code_ += sizeof(value);
+        }
+
+        void Imm64(const uint64_t value)
+        {
+            std::memcpy(code_, &value, sizeof(value));
+            code_ += sizeof(value);
+        }
+
+        //
+        // Emits a jump with a 32-bit displacement and returns where the
+        // displacement lives, so it can be patched once the target is known.
+        //
+        uint8_t* Jump(const uint8_t* target = nullptr)
+        {
+            Byte(0xE9);
+            return Rel32(target);
+        }
+
+        uint8_t* JumpIf(const uint8_t condition, const uint8_t* target = nullptr)
+        {
+            Bytes(0x0F, 0x80 | condition);
+            return Rel32(target);
+        }
+
+        //
+        // Emits opcode followed by a ModRM byte with reg in its reg field and either
+        // the host register rm or, for kMemory, [rbx + disp] in its r/m field.
+        // Byte registers above bl always get a REX prefix, so 4-7 are spl-dil and not ah-bh.
+        //
+        template <typename... Opcode>
+        void ModRm(const uint8_t reg, const uint8_t rm, const uint8_t disp, const Opcode... opcode)
+        {
+            const bool is_memory = rm == kMemory;
+            if (reg >= 4 || (!is_memory && rm >= 4))
+            {
+                Byte(0x40 | ((reg & 0x8) >> 1) | (is_memory ? 0 : (rm & 0x8) >> 3));
+            }
+
+            Bytes(opcode...);
+            if (is_memory)
+            {
+                Bytes(0x43 | (reg & 0x7) << 3, disp);
+            }
+            else
+            {
+                Byte(0xC0 | (reg & 0x7) << 3 | (rm & 0x7));
+            }
+        }
+
+        static void Patch(uint8_t* displacement, const uint8_t* target)
+        {
+            const auto rel = static_cast<int32_t>(target - (displacement + 4));
+            std::memcpy(displacement, &rel, sizeof(rel));
+        }
+
+        // Condition codes for JumpIf
+        static constexpr uint8_t kEqual = 0x4;
+        static constexpr uint8_t kNotEqual = 0x5;
+        static constexpr uint8_t kLess = 0xC;
+
+        // Host registers
+        static constexpr uint8_t kAl = 0;
+        static constexpr uint8_t kCl = 1;
+        static constexpr uint8_t kMemory = 0xFF;
+
+    private:
+        uint8_t* Rel32(const uint8_t* target)
+        {
+            const auto displacement = code_;
+            Imm32(0);
+            if (target != nullptr)
+            {
+                Patch(displacement, target);
+            }
+
+            return displacement;
+        }
+
+        uint8_t* code_;
+    };
+
+    //
+    // Basic block JIT for x86-64 Linux.
+    //
+    // Blocks end at jumps, calls, returns, skips and traps. Simple ALU, index and timer
+    // instructions are translated to native code working directly on Registers.
+    // Everything touching the display, keyboard, stack or memory calls back into the
+    // interpreter handler for that instruction, which keeps a single implementation
+    // of their semantics.
+    //
+    // Pinned host registers while inside translated code:
+    //   rbx - Registers of the machine
+    //   r12 - remaining instruction budget
+    //   r13 - this Jit, passed to the interpreter callback
+    //   r14 - where to store the budget on exit
+    //
+    // V registers a block uses more than once are cached in the remaining host
+    // registers: loaded after the budget check, written back if modified before
+    // every exit and interpreter call, and reloaded after the call.
+    //
+    // The code cache is never writable and executable at the same time. It's made
+    // writable to translate or link blocks and executable again before entering them.
+    //
+    // Blocks with a static successor are linked by patching their exit jump to go
+    // straight to the successor's entry. Any write to translated bytes flushes the
+    // whole code cache, which also drops every link.
+    //
+    template <typename CpuType>
+    class Jit
+    {
+    public:
+        explicit Jit(CpuType& cpu)
+            : cpu_{ cpu }
+        {
+            code_ = static_cast<uint8_t*>(mmap(nullptr, kCodeCacheSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (code_ == MAP_FAILED)
+            {
+                throw std::runtime_error{ "Could not allocate the JIT code cache" };
+            }
+
+            EmitTrampoline();
+            cpu_.memory_.AttachCodeMap(&code_map_);
+        }
+
+        Jit(const Jit&) = delete;
+        Jit(Jit&&) = delete;
+
+        Jit& operator=(const Jit&) = delete;
+        Jit& operator=(Jit&&) = delete;
+
+        ~Jit()
+        {
+            cpu_.memory_.AttachCodeMap(nullptr);
+            munmap(code_, kCodeCacheSize);
+        }
+
+        //
+        // Execute exactly budget instructions unless an opcode traps or throws.
+        // Blocks longer than what's left of the budget are interpreted.
+        //
+        uint64_t Execute(const uint64_t budget)
+        {
+            auto remaining = static_cast<int64_t>(budget);
+
+            uint8_t* link_site = nullptr;
+            uint64_t link_generation = generation_;
+
+            while (remaining > 0 && !cpu_.IsStopped())
+            {
+                if (code_map_.IsFlushPending())
+                {
+                    Flush();
+                }
+
+                const auto block = FindOrCompile(cpu_.registers_.pc);
+                if (block == nullptr || block->length > remaining)
+                {
+                    remaining -= static_cast<int64_t>(cpu_.ExecuteHandlers(1));
+                    link_site = nullptr;
+                    continue;
+                }
+
+                if (link_site != nullptr && link_generation == generation_)
+                {
+                    SetWritable(true);
+                    X64Emitter::Patch(link_site + 1, block->entry);
+                }
+
+                SetWritable(false);
+                link_generation = generation_;
+                link_site = reinterpret_cast<uint8_t*>(enter_(&cpu_.registers_, this, &remaining, block->entry));
+
+                if (exception_)
+                {
+                    std::rethrow_exception(std::exchange(exception_, nullptr));
+                }
+            }
+
+            return budget - static_cast<uint64_t>(remaining);
+        }
+
+    private:
+        struct Block
+        {
+            const uint8_t* entry = nullptr;
+            int64_t length = 0;
+        };
+
+        using Trampoline = uint64_t(*)(Registers*, Jit*, int64_t*, const uint8_t*);
+
+        static constexpr size_t kCodeCacheSize = 4 * 1024 * 1024;
+        static constexpr size_t kMaxBlockLength = 64;
+
+        //
+        // Worst case of native code per instruction, plus the block prologue and exits.
+        // Includes loading and storing every cached V register around an interpreter call.
+        //
+        static constexpr size_t kMaxInstructionSize = 160;
+        static constexpr size_t kMaxBlockSize = (kMaxBlockLength + 4) * kMaxInstructionSize;
+
+        static constexpr uint8_t kPc = offsetof(Registers, pc);
+        static constexpr uint8_t kIndex = offsetof(Registers, index);
+        static constexpr uint8_t kDelayTimer = offsetof(Registers, delay_timer);
+        static constexpr uint8_t kSoundTimer = offsetof(Registers, sound_timer);
+        static constexpr uint8_t kV = offsetof(Registers, v);
+        static_assert(sizeof(Registers) < 0x80, "Registers must be reachable with disp8");
+
+        static constexpr uint8_t V(const uint8_t x)
+        {
+            return static_cast<uint8_t>(kV + x);
+        }
+
+        //
+        // Host registers V registers can be cached in: rdx, rsi, rdi, r8-r11, rbp and r15.
+        // Everything caller-saved is written back before calling the interpreter anyway.
+        //
+        static constexpr std::array<uint8_t, 9> kCacheRegisters = { 2, 6, 7, 8, 9, 10, 11, 5, 15 };
+
+        //
+        // V registers read and written by an instruction, as masks.
+        // Only covers instructions with a native translation.
+        //
+        struct RegisterUse
+        {
+            uint16_t reads = 0;
+            uint16_t writes = 0;
+        };
+
+        static RegisterUse UsesOf(const DecodedInstruction& decoded)
+        {
+            const auto x = static_cast<uint16_t>(1 << decoded.x);
+            const auto y = static_cast<uint16_t>(1 << decoded.y);
+            const uint16_t f = 1 << 0xF;
+
+            switch (decoded.instruction)
+            {
+            case Instruction::kSkipNextInstructionIfEq:
+            case Instruction::kSkipNextInstructionIfNotEq:
+            case Instruction::kSetDelayTimer:
+            case Instruction::kSetSoundTimer:
+            case Instruction::kAddIVx:
+            case Instruction::kSetSpriteFromVx:
+                return { x, 0 };
+            case Instruction::kSkipNextInstructionIfXEqY:
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+                return { static_cast<uint16_t>(x | y), 0 };
+            case Instruction::kSetVxRegister:
+            case Instruction::kStoreDelayTimer:
+                return { 0, x };
+            case Instruction::kAddToRegister:
+                return { x, x };
+            case Instruction::kSetVxVy:
+                return { y, x };
+            case Instruction::kOrVxVy:
+            case Instruction::kAndVxVy:
+            case Instruction::kXorVxVy:
+                return { static_cast<uint16_t>(x | y), x };
+            case Instruction::kAddVxVy:
+            case Instruction::kSubVxVy:
+            case Instruction::kSubnVxVy:
+                return { static_cast<uint16_t>(x | y), static_cast<uint16_t>(x | f) };
+            case Instruction::kShrVxVy:
+            case Instruction::kShlVxVy:
+                return { x, static_cast<uint16_t>(x | f) };
+            default:
+                return {};
+            }
+        }
+
+        //
+        // Called from translated code for instructions without a native translation.
+        // Returns false if the block must exit right away: the instruction trapped,
+        // threw, waits for a key or overwrote translated code.
+        //
+        static bool Interpret(Jit* jit, const DecodedInstruction* decoded)
+        {
+            try
+            {
+                decoded->handler(jit->cpu_, *decoded);
+            }
+            catch (...)
+            {
+                jit->exception_ = std::current_exception();
+                return false;
+            }
+
+            return !jit->cpu_.IsStopped() && !jit->code_map_.IsFlushPending();
+        }
+
+        static bool EndsBlock(const Instruction instruction)
+        {
+            switch (instruction)
+            {
+            case Instruction::kSys:
+            case Instruction::kReturn:
+            case Instruction::kJump:
+            case Instruction::kCall:
+            case Instruction::kJumpOffset:
+            case Instruction::kSkipNextInstructionIfEq:
+            case Instruction::kSkipNextInstructionIfNotEq:
+            case Instruction::kSkipNextInstructionIfXEqY:
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+            case Instruction::kSkipIfPressed:
+            case Instruction::kSkipIfNotPressed:
+            case Instruction::kStoreKeyPress:
+            case Instruction::kInvalid:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        const Block* FindOrCompile(const uint16_t pc)
+        {
+            if (pc >= kMemorySize)
+            {
+                return nullptr;
+            }
+
+            if (blocks_[pc].entry == nullptr)
+            {
+                Compile(pc);
+            }
+
+            return blocks_[pc].entry != nullptr ? &blocks_[pc] : nullptr;
+        }
+
+        void Flush()
+        {
+            cursor_ = code_ + trampoline_size_;
+            blocks_.fill(Block{});
+            decoded_.clear();
+            code_map_.Clear();
+            generation_++;
+        }
+
+        void SetWritable(const bool is_writable)
+        {
+            if (is_writable_ == is_writable)
+            {
+                return;
+            }
+
+            if (mprotect(code_, kCodeCacheSize, is_writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) != 0)
+            {
+                throw std::runtime_error{ "Could not change the protection of the JIT code cache" };
+            }
+
+            is_writable_ = is_writable;
+        }
+
+        //
+        // Pick the V registers used more than once in the block, most used first,
+        // and assign them host registers.
+        //
+        void AllocateRegisters(const std::vector<DecodedInstruction>& instructions)
+        {
+            std::array<uint32_t, kNumberOfGeneralRegisters> uses{};
+            for (const auto& decoded : instructions)
+            {
+                const auto use = UsesOf(decoded);
+                for (uint8_t x = 0; x < kNumberOfGeneralRegisters; x++)
+                {
+                    uses[x] += ((use.reads | use.writes) >> x) & 0x1;
+                }
+            }
+
+            host_.fill(X64Emitter::kMemory);
+            cached_ = 0;
+            dirty_ = 0;
+
+            for (const auto host : kCacheRegisters)
+            {
+                uint8_t best = 0;
+                for (uint8_t x = 1; x < kNumberOfGeneralRegisters; x++)
+                {
+                    if (uses[x] > uses[best])
+                    {
+                        best = x;
+                    }
+                }
+
+                if (uses[best] < 2)
+                {
+                    break;
+                }
+
+                host_[best] = host;
+                cached_ |= 1 << best;
+                uses[best] = 0;
+            }
+        }
+
+        void Compile(const uint16_t pc)
+        {
+            std::vector<DecodedInstruction> instructions;
+            for (uint16_t address = pc; instructions.size() < kMaxBlockLength && address + 1 < kMemorySize; address += 2)
+            {
+                auto fetch_address = address;
+                const auto opcode = cpu_.memory_.FetchOpcode(fetch_address);
+                instructions.push_back(DecodedInstruction::From(opcode, CpuType::LookupInstruction(opcode.Value())));
+
+                if (EndsBlock(instructions.back().instruction))
+                {
+                    break;
+                }
+            }
+
+            if (instructions.empty())
+            {
+                return;
+            }
+
+            if (cursor_ + kMaxBlockSize > code_ + kCodeCacheSize)
+            {
+                Flush();
+            }
+
+            SetWritable(true);
+            AllocateRegisters(instructions);
+
+            X64Emitter emit{ cursor_ };
+            const auto length = static_cast<uint32_t>(instructions.size());
+
+            //
+            // Bail out to the dispatcher if the budget can't cover the whole block.
+            //
+            const auto entry = emit.Position();
+            emit.Bytes(0x49, 0x81, 0xFC);                   // cmp r12, length
+            emit.Imm32(length);
+            const auto bail = emit.JumpIf(X64Emitter::kLess);
+            emit.Bytes(0x49, 0x81, 0xEC);                   // sub r12, length
+            emit.Imm32(length);
+            EmitLoad(emit);
+
+            for (uint32_t i = 0; i < length; i++)
+            {
+                const auto& decoded = instructions[i];
+                const auto address = static_cast<uint16_t>(pc + 2 * i);
+                const auto next = static_cast<uint16_t>(address + 2);
+
+                if (EmitNative(emit, decoded, address))
+                {
+                    dirty_ |= UsesOf(decoded).writes & cached_;
+                }
+                else
+                {
+                    EmitInterpret(emit, decoded, next, length - i - 1);
+                }
+
+                if (i == length - 1 && !EndsBlock(decoded.instruction))
+                {
+                    EmitLinkableExit(emit, next);
+                }
+            }
+
+            //
+            // Nothing is cached yet when the budget check fails.
+            //
+            X64Emitter::Patch(bail, emit.Position());
+            dirty_ = 0;
+            EmitLinkableExit(emit, pc, false);
+
+            cursor_ = emit.Position();
+            blocks_[pc] = Block{ entry, length };
+            code_map_.Mark(pc, 2 * length);
+        }
+
+        //
+        // Translate instructions that only touch Registers.
+        // Block terminators also emit their exits.
+        //
+        bool EmitNative(X64Emitter& emit, const DecodedInstruction& decoded, const uint16_t address)
+        {
+            constexpr auto kAl = X64Emitter::kAl;
+            constexpr auto kCl = X64Emitter::kCl;
+
+            const auto x = decoded.x;
+            const auto y = decoded.y;
+            const uint8_t f = 0xF;
+
+            switch (decoded.instruction)
+            {
+            case Instruction::kJump:
+                EmitLinkableExit(emit, decoded.nnn);
+                return true;
+            case Instruction::kSkipNextInstructionIfEq:
+            case Instruction::kSkipNextInstructionIfNotEq:
+            {
+                EmitV(emit, 7, x, 0x80);                    // cmp vx, nn
+                emit.Byte(decoded.nn);
+                const auto skip_if = decoded.instruction == Instruction::kSkipNextInstructionIfEq ? X64Emitter::kEqual : X64Emitter::kNotEqual;
+                EmitSkip(emit, skip_if, address);
+                return true;
+            }
+            case Instruction::kSkipNextInstructionIfXEqY:
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+            {
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x38);                  // cmp vx, al
+                const auto skip_if = decoded.instruction == Instruction::kSkipNextInstructionIfXEqY ? X64Emitter::kEqual : X64Emitter::kNotEqual;
+                EmitSkip(emit, skip_if, address);
+                return true;
+            }
+            case Instruction::kSetVxRegister:
+                EmitV(emit, 0, x, 0xC6);                    // mov vx, nn
+                emit.Byte(decoded.nn);
+                return true;
+            case Instruction::kAddToRegister:
+                EmitV(emit, 0, x, 0x80);                    // add vx, nn
+                emit.Byte(decoded.nn);
+                return true;
+            case Instruction::kSetVxVy:
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x88);                  // mov vx, al
+                return true;
+            case Instruction::kOrVxVy:
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x08);                  // or vx, al
+                return true;
+            case Instruction::kAndVxVy:
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x20);                  // and vx, al
+                return true;
+            case Instruction::kXorVxVy:
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x30);                  // xor vx, al
+                return true;
+
+            //
+            // The flag is written before the result, like the interpreter does.
+            // That matters when x or y is 0xF.
+            //
+            case Instruction::kAddVxVy:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                EmitV(emit, kAl, y, 0x02);                  // add al, vy
+                emit.Bytes(0x0F, 0x92, 0xC1);               // setc cl
+                EmitV(emit, kCl, f, 0x88);                  // mov vf, cl
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x00);                  // add vx, al
+                return true;
+            case Instruction::kSubVxVy:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                EmitV(emit, kAl, y, 0x3A);                  // cmp al, vy
+                emit.Bytes(0x0F, 0x93, 0xC1);               // setae cl
+                EmitV(emit, kCl, f, 0x88);                  // mov vf, cl
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x28);                  // sub vx, al
+                return true;
+            case Instruction::kSubnVxVy:
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x3A);                  // cmp al, vx
+                emit.Bytes(0x0F, 0x93, 0xC1);               // setae cl
+                EmitV(emit, kCl, f, 0x88);                  // mov vf, cl
+                EmitV(emit, kAl, y, 0x0F, 0xB6);            // movzx eax, vy
+                EmitV(emit, kAl, x, 0x2A);                  // sub al, vx
+                EmitV(emit, kAl, x, 0x88);                  // mov vx, al
+                return true;
+            case Instruction::kShrVxVy:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0x24, 0x01);                     // and al, 1
+                EmitV(emit, kAl, f, 0x88);                  // mov vf, al
+                EmitV(emit, 5, x, 0xD0);                    // shr vx, 1
+                return true;
+            case Instruction::kShlVxVy:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0xC0, 0xE8, 0x07);               // shr al, 7
+                EmitV(emit, kAl, f, 0x88);                  // mov vf, al
+                EmitV(emit, 4, x, 0xD0);                    // shl vx, 1
+                return true;
+            case Instruction::kSetIndexRegister:
+                emit.Bytes(0x66, 0xC7, 0x43, kIndex);       // mov word [index], nnn
+                emit.Imm16(decoded.nnn);
+                return true;
+            case Instruction::kStoreDelayTimer:
+                emit.Bytes(0x8A, 0x43, kDelayTimer);        // mov al, [delay_timer]
+                EmitV(emit, kAl, x, 0x88);                  // mov vx, al
+                return true;
+            case Instruction::kSetDelayTimer:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0x88, 0x43, kDelayTimer);        // mov [delay_timer], al
+                return true;
+            case Instruction::kSetSoundTimer:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0x88, 0x43, kSoundTimer);        // mov [sound_timer], al
+                return true;
+            case Instruction::kAddIVx:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0x66, 0x01, 0x43, kIndex);       // add [index], ax
+                return true;
+            case Instruction::kSetSpriteFromVx:
+                EmitV(emit, kAl, x, 0x0F, 0xB6);            // movzx eax, vx
+                emit.Bytes(0x8D, 0x04, 0x80);               // lea eax, [rax + rax * 4]
+                static_assert(kSpriteSize == 5);
+                emit.Byte(0x05);                            // add eax, kSpritesAddress
+                emit.Imm32(kSpritesAddress);
+                emit.Bytes(0x66, 0x89, 0x43, kIndex);       // mov [index], ax
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        //
+        // Call the interpreter for a single instruction, pc already pointing past it.
+        // If it asks to stop, refund the part of the budget the block won't execute.
+        //
+        void EmitInterpret(X64Emitter& emit, const DecodedInstruction& decoded, const uint16_t next, const uint32_t refund)
+        {
+            decoded_.push_back(decoded);
+
+            EmitStore(emit);
+            dirty_ = 0;
+
+            emit.Bytes(0x66, 0xC7, 0x43, kPc);              // mov word [pc], next
+            emit.Imm16(next);
+            emit.Bytes(0x4C, 0x89, 0xEF);                   // mov rdi, r13
+            emit.Bytes(0x48, 0xBE);                         // mov rsi, &decoded
+            emit.Imm64(reinterpret_cast<uint64_t>(&decoded_.back()));
+            emit.Bytes(0x48, 0xB8);                         // mov rax, Interpret
+            emit.Imm64(reinterpret_cast<uint64_t>(&Interpret));
+            emit.Bytes(0xFF, 0xD0);                         // call rax
+
+            if (EndsBlock(decoded.instruction) && decoded.instruction != Instruction::kCall)
+            {
+                //
+                // The interpreter already set pc, return to the dispatcher.
+                //
+                EmitExit(emit);
+                return;
+            }
+
+            emit.Bytes(0x84, 0xC0);                         // test al, al
+            const auto keep_going = emit.JumpIf(X64Emitter::kNotEqual);
+            emit.Bytes(0x49, 0x81, 0xC4);                   // add r12, refund
+            emit.Imm32(refund);
+            EmitExit(emit);
+            X64Emitter::Patch(keep_going, emit.Position());
+
+            if (decoded.instruction == Instruction::kCall)
+            {
+                EmitLinkableExit(emit, decoded.nnn);
+                return;
+            }
+
+            EmitLoad(emit);
+        }
+
+        void EmitSkip(X64Emitter& emit, const uint8_t skip_if, const uint16_t address)
+        {
+            const auto skip = emit.JumpIf(skip_if);
+            EmitLinkableExit(emit, static_cast<uint16_t>(address + 2));
+            X64Emitter::Patch(skip, emit.Position());
+            EmitLinkableExit(emit, static_cast<uint16_t>(address + 4));
+        }
+
+        //
+        // Leave the block for a known pc. The dispatcher gets the address of
+        // the final jump and patches it to go straight to the next block.
+        //
+        void EmitLinkableExit(X64Emitter& emit, const uint16_t target, const bool linkable = true)
+        {
+            emit.Bytes(0x66, 0xC7, 0x43, kPc);              // mov word [pc], target
+            emit.Imm16(target);
+
+            if (!linkable)
+            {
+                EmitExit(emit);
+                return;
+            }
+
+            EmitStore(emit);
+            emit.Bytes(0x48, 0x8D, 0x05);                   // lea rax, [rip]
+            emit.Imm32(0);
+            emit.Jump(exit_);                               // jmp exit
+        }
+
+        void EmitExit(X64Emitter& emit)
+        {
+            EmitStore(emit);
+            emit.Bytes(0x31, 0xC0);                         // xor eax, eax
+            emit.Jump(exit_);                               // jmp exit
+        }
+
+        //
+        // Emits opcode with V[x] as its r/m operand, wherever V[x] lives in this block.
+        //
+        template <typename... Opcode>
+        void EmitV(X64Emitter& emit, const uint8_t reg, const uint8_t x, const Opcode... opcode)
+        {
+            emit.ModRm(reg, host_[x], V(x), opcode...);
+        }
+
+        //
+        // Load every cached V register from Registers.
+        //
+        void EmitLoad(X64Emitter& emit)
+        {
+            for (uint8_t x = 0; x < kNumberOfGeneralRegisters; x++)
+            {
+                if (cached_ & (1 << x))
+                {
+                    emit.ModRm(host_[x], X64Emitter::kMemory, V(x), 0x0F, 0xB6);  // movzx host, [vx]
+                }
+            }
+        }
+
+        //
+        // Write the cached V registers modified so far back to Registers.
+        //
+        void EmitStore(X64Emitter& emit)
+        {
+            for (uint8_t x = 0; x < kNumberOfGeneralRegisters; x++)
+            {
+                if (dirty_ & (1 << x))
+                {
+                    emit.ModRm(host_[x], X64Emitter::kMemory, V(x), 0x88);  // mov [vx], host
+                }
+            }
+        }
+
+        //
+        // uint64_t enter(Registers* registers, Jit* jit, int64_t* budget, const uint8_t* block)
+        // Saves the callee-saved registers, pins the state and jumps into the block.
+        // Blocks jump back to exit_ with the link site, or 0, in rax.
+        //
+        void EmitTrampoline()
+        {
+            X64Emitter emit{ code_ };
+
+            emit.Byte(0x53);                                // push rbx
+            emit.Byte(0x55);                                // push rbp
+            emit.Bytes(0x41, 0x54);                         // push r12
+            emit.Bytes(0x41, 0x55);                         // push r13
+            emit.Bytes(0x41, 0x56);                         // push r14
+            emit.Bytes(0x41, 0x57);                         // push r15
+            emit.Bytes(0x48, 0x83, 0xEC, 0x08);             // sub rsp, 8 to keep calls 16-byte aligned
+            emit.Bytes(0x48, 0x89, 0xFB);                   // mov rbx, rdi
+            emit.Bytes(0x49, 0x89, 0xF5);                   // mov r13, rsi
+            emit.Bytes(0x49, 0x89, 0xD6);                   // mov r14, rdx
+            emit.Bytes(0x4C, 0x8B, 0x22);                   // mov r12, [rdx]
+            emit.Bytes(0xFF, 0xE1);                         // jmp rcx
+
+            exit_ = emit.Position();
+            emit.Bytes(0x4D, 0x89, 0x26);                   // mov [r14], r12
+            emit.Bytes(0x48, 0x83, 0xC4, 0x08);             // add rsp, 8
+            emit.Bytes(0x41, 0x5F);                         // pop r15
+            emit.Bytes(0x41, 0x5E);                         // pop r14
+            emit.Bytes(0x41, 0x5D);                         // pop r13
+            emit.Bytes(0x41, 0x5C);                         // pop r12
+            emit.Byte(0x5D);                                // pop rbp
+            emit.Byte(0x5B);                                // pop rbx
+            emit.Byte(0xC3);                                // ret
+
+            enter_ = reinterpret_cast<Trampoline>(code_);
+            trampoline_size_ = static_cast<size_t>(emit.Position() - code_);
+            cursor_ = emit.Position();
+        }
+
+        CpuType& cpu_;
+
+        //
+        // Executable code cache. The trampoline sits at the start and survives flushes.
+        //
+        uint8_t* code_ = nullptr;
+        uint8_t* cursor_ = nullptr;
+        size_t trampoline_size_ = 0;
+        Trampoline enter_ = nullptr;
+        const uint8_t* exit_ = nullptr;
+        bool is_writable_ = true;
+
+        //
+        // Where each V register lives in the block being translated, which are
+        // cached in host registers and which of those were modified since loading them.
+        //
+        std::array<uint8_t, kNumberOfGeneralRegisters> host_{};
+        uint16_t cached_ = 0;
+        uint16_t dirty_ = 0;
+
+        //
+        // Translated blocks by starting pc.
+        //
+        std::array<Block, kMemorySize> blocks_{};
+
+        //
+        // Instructions handed to the interpreter by translated code.
+        // A deque so their addresses stay stable while blocks are added.
+        //
+        std::deque<DecodedInstruction> decoded_;
+
+        CodeMap code_map_;
+
+        //
+        // Bumped on every flush so stale link sites are never patched.
+        //
+        uint64_t generation_ = 0;
+
+        //
+        // Exception thrown by an interpreted instruction, rethrown outside translated code.
+        //
+        std::exception_ptr exception_;
+    };
+#endif
+}
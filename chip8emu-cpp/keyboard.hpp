@@ -1,20 +1,31 @@
 #pragma once
 #include <algorithm>
 
-#include <algorithm>
-#include <cstdint>
 #include <array>
-#include <format>
-#include <stdexcept>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
 
 #include "SDL.h"
 
 namespace chip8_emu
 {
+    //
+    // Host keyboard. Tracks the CHIP-8 keys from SDL key events as they're pumped
+    // by the window's event loop, so reading them is a single load.
+    // Headless keyboards never see any events.
+    //
     class Keyboard
     {
     public:
-        Keyboard() = default;
+        explicit Keyboard(const bool is_headless = false)
+            : is_headless_{ is_headless }
+        {
+            if (!is_headless_)
+            {
+                SDL_AddEventWatch(&Keyboard::OnEvent, this);
+            }
+        }
 
         Keyboard(const Keyboard&) = delete;
         Keyboard(Keyboard&&) = delete;
@@ -22,44 +33,61 @@ namespace chip8_emu
         Keyboard& operator=(const Keyboard&) = delete;
         Keyboard& operator=(Keyboard&&) = delete;
 
-        ~Keyboard() = default;
-
-        uint8_t WaitForKeyPress()
+        ~Keyboard()
         {
-            SDL_Event event;
-            while (SDL_PollEvent(&event))
+            if (!is_headless_)
             {
-                if (event.type == SDL_KEYDOWN)
-                {
-                    const auto it = std::find(uint_to_scancode_.begin(), uint_to_scancode_.end(), event.key.keysym.scancode);
-
-                    if (it != uint_to_scancode_.end())
-                    {
-                        return static_cast<uint8_t>(std::distance(uint_to_scancode_.begin(), it));
-                    }
-                }
+                SDL_DelEventWatch(&Keyboard::OnEvent, this);
             }
+        }
 
-            throw std::runtime_error{ "Unexpected exit from WaitForKeyPress function" };
+        bool IsHeadless() const
+        {
+            return is_headless_;
         }
 
-        bool IsKeyPressed(const uint8_t key) const
+        //
+        // Bit N is set while key N is held.
+        //
+        uint16_t GetKeys() const
         {
-            if (key >= uint_to_scancode_.size())
+            return keys_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        //
+        // Runs on whichever thread pumps SDL events.
+        //
+        static int SDLCALL OnEvent(void* userdata, SDL_Event* event)
+        {
+            if (event->type != SDL_KEYDOWN && event->type != SDL_KEYUP)
             {
-                throw std::runtime_error{ std::format("Could not find {:#x} key", key) };
+                return 0;
             }
 
-            const auto scancode = uint_to_scancode_[key];
-            const auto state = SDL_GetKeyboardState(nullptr);
-            if (state[scancode])
+            const auto it = std::find(uint_to_scancode_.begin(), uint_to_scancode_.end(), event->key.keysym.scancode);
+            if (it == uint_to_scancode_.end())
             {
-                return true;
+                return 0;
             }
 
-            return false;
+            const auto bit = static_cast<uint16_t>(1 << std::distance(uint_to_scancode_.begin(), it));
+            auto& keys = static_cast<Keyboard*>(userdata)->keys_;
+            if (event->type == SDL_KEYDOWN)
+            {
+                keys.fetch_or(bit, std::memory_order_relaxed);
+            }
+            else
+            {
+                keys.fetch_and(static_cast<uint16_t>(~bit), std::memory_order_relaxed);
+            }
+
+            return 0;
         }
-    private:
+
+        bool is_headless_;
+        std::atomic<uint16_t> keys_ = 0;
+
         static constexpr std::array<SDL_Scancode, 16> uint_to_scancode_
         {
             SDL_SCANCODE_X, // 0x0
@@ -0,0 +1,794 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "display.hpp"
+#include "display_backend.hpp"
+#include "memory.hpp"
+#include "constants.hpp"
+#include "decoder.hpp"
+#include "decode_cache.hpp"
+#include "keyboard.hpp"
+#include "rng.hpp"
+#include "savestate.hpp"
+#include "sdl_display_backend.hpp"
+#include "stack.hpp"
+#include "speaker.hpp"
+
+namespace chip8_emu
+{
+    //
+    // CHIP-8 machine state and instruction semantics.
+    // How instructions get executed is left to Cpu.
+    //
+    class Machine
+    {
+    public:
+        explicit Machine(const Frontend frontend = Frontend::kWindowed)
+            : display_{ MakeDisplayBackend(frontend) }
+            , keyboard_{ frontend == Frontend::kHeadless }
+            , speaker_{ frontend == Frontend::kHeadless }
+        {
+            memory_.AttachDecodeCache(&decode_cache_);
+        }
+
+        Machine(const Machine&) = delete;
+        Machine(Machine&&) = delete;
+
+        Machine& operator=(const Machine&) = delete;
+        Machine& operator=(Machine&&) = delete;
+
+        ~Machine() = default;
+
+        const Registers& GetRegisters() const
+        {
+            return registers_;
+        }
+
+        bool IsTrapped() const
+        {
+            return is_trapped_;
+        }
+
+        Opcode GetTrapOpcode() const
+        {
+            return trap_opcode_;
+        }
+
+        //
+        // Memory and its fault register, which is only ever set in builds
+        // with CHIP8_CHECKED_MEMORY defined.
+        //
+        const Memory<>& GetMemory() const
+        {
+            return memory_;
+        }
+
+        //
+        // Set while FX0A waits for a key. No instructions execute until
+        // the keys change to something pressed, timers keep ticking.
+        //
+        bool IsWaitingForKey() const
+        {
+            return is_waiting_for_key_;
+        }
+
+        //
+        // Waiting for a key with both timers expired, so nothing but input can change the machine.
+        //
+        bool IsParked() const
+        {
+            return is_waiting_for_key_ && registers_.delay_timer == 0 && registers_.sound_timer == 0;
+        }
+
+        //
+        // Recognise loops that only wait for the delay timer or a key, and skip
+        // what's left of the frame instead of running them, see Cpu::SkipIdleLoop.
+        // The outcome is exactly the same either way.
+        //
+        void SetIdleLoopSkipping(const bool is_enabled)
+        {
+            is_idle_loop_skipping_ = is_enabled;
+            idle_jump_ = kNoIdleJump;
+        }
+
+        bool IsIdleLoopSkipping() const
+        {
+            return is_idle_loop_skipping_;
+        }
+
+        //
+        // Seed the random number generator CXNN reads from.
+        // Every machine has its own, so runs with the same seed are reproducible.
+        //
+        void Seed(const uint32_t seed)
+        {
+            rng_.Seed(seed);
+            seed_ = seed;
+        }
+
+        uint32_t GetSeed() const
+        {
+            return seed_;
+        }
+
+        //
+        // Keys the program sees, bit N is key N. They only change between frames:
+        // either PollKeys copies the host keyboard, or they're set from a script or movie.
+        //
+        uint16_t GetKeys() const
+        {
+            return keys_;
+        }
+
+        void SetKeys(const uint16_t keys)
+        {
+            keys_ = keys;
+            ResumeIfKeyPressed();
+        }
+
+        //
+        // Latch the host keyboard for the next frame. Headless machines keep their keys.
+        //
+        void PollKeys()
+        {
+            if (!keyboard_.IsHeadless())
+            {
+                keys_ = keyboard_.GetKeys();
+                ResumeIfKeyPressed();
+            }
+        }
+
+        const Framebuffer& GetFramebuffer() const
+        {
+            return display_.GetFramebuffer();
+        }
+
+        //
+        // Hand the screen to the display backend if it changed since the last call.
+        // Run does it once per frame. Headless runs never present unless they call this.
+        //
+        void PresentFrame()
+        {
+            display_.Refresh();
+        }
+
+        //
+        // Replace where frames are presented, e.g. to capture them in tests.
+        //
+        void SetDisplayBackend(std::unique_ptr<DisplayBackend> backend)
+        {
+            display_.SetBackend(std::move(backend));
+        }
+
+        //
+        // Snapshot everything a program can observe: registers, timers, stack, memory,
+        // the screen and the random number generator.
+        //
+        std::vector<uint8_t> SaveState() const
+        {
+            std::vector<uint8_t> bytes;
+            bytes.reserve(sizeof(kSavestateMagic) + sizeof(kSavestateVersion) + kStateSize);
+
+            StateWriter writer{ bytes };
+            writer.WriteBytes(kSavestateMagic, sizeof(kSavestateMagic));
+            writer.WriteU16(kSavestateVersion);
+
+            stack_.SaveState(writer);
+
+            writer.WriteU16(registers_.pc);
+            writer.WriteU16(registers_.index);
+            writer.WriteU8(registers_.delay_timer);
+            writer.WriteU8(registers_.sound_timer);
+            writer.WriteBytes(registers_.v, kNumberOfGeneralRegisters);
+
+            memory_.SaveState(writer);
+            display_.SaveState(writer);
+
+            rng_.SaveState(writer);
+
+            writer.WriteU8(is_trapped_);
+            writer.WriteU16(trap_opcode_.Value());
+
+            writer.WriteU8(is_waiting_for_key_);
+            writer.WriteU8(key_register_);
+
+            return bytes;
+        }
+
+        //
+        // Restore a snapshot taken with SaveState. The machine is left untouched
+        // if the snapshot is invalid or from another version.
+        //
+        void LoadState(const std::vector<uint8_t>& bytes)
+        {
+            StateReader reader{ bytes.data(), bytes.size() };
+
+            uint8_t magic[sizeof(kSavestateMagic)];
+            reader.ReadBytes(magic, sizeof(magic));
+            if (std::memcmp(magic, kSavestateMagic, sizeof(magic)) != 0)
+            {
+                throw std::runtime_error{ "Not a savestate" };
+            }
+
+            const auto version = reader.ReadU16();
+            if (version != kSavestateVersion)
+            {
+                throw std::runtime_error{ std::format("Unsupported savestate version {}, expected {}", version, kSavestateVersion) };
+            }
+
+            if (reader.GetRemaining() != kStateSize)
+            {
+                throw std::runtime_error{ std::format("Savestate has {} bytes of state, expected {}", reader.GetRemaining(), kStateSize) };
+            }
+
+            //
+            // The stack goes first, it's the only part that can still be rejected.
+            //
+            stack_.LoadState(reader);
+
+            registers_.pc = reader.ReadU16();
+            registers_.index = reader.ReadU16();
+            registers_.delay_timer = reader.ReadU8();
+            registers_.sound_timer = reader.ReadU8();
+            reader.ReadBytes(registers_.v, kNumberOfGeneralRegisters);
+
+            memory_.LoadState(reader);
+            display_.LoadState(reader);
+
+            rng_.LoadState(reader);
+
+            is_trapped_ = reader.ReadU8() != 0;
+            const auto trap_opcode = reader.ReadU16();
+            trap_opcode_.first_byte = static_cast<uint8_t>(trap_opcode >> 8);
+            trap_opcode_.second_byte = static_cast<uint8_t>(trap_opcode);
+
+            is_waiting_for_key_ = reader.ReadU8() != 0;
+            key_register_ = reader.ReadU8() & 0xF;
+
+            idle_jump_ = kNoIdleJump;
+        }
+
+        void Load(const std::vector<uint8_t>& bytes)
+        {
+            memory_.Write(bytes, 0x200);
+            idle_jump_ = kNoIdleJump;
+
+            //
+            // CHIP-8 programs are usually loaded at 0x200
+            //
+            registers_.pc = 0x200;
+        }
+
+        //
+        // One indexed load from a table covering all 64K opcodes, giving the
+        // handler, the instruction and its index without decoding anything.
+        // Opcodes that don't decode point to the trap handler.
+        //
+        static const DispatchEntry& LookupInstruction(const OpcodeType opcode);
+
+    protected:
+        //
+        // Size of a savestate after the magic and version.
+        //
+        static constexpr size_t kStateSize =
+            1 + 2 * kStackSize +                        // sp and stack
+            2 + 2 + 1 + 1 + kNumberOfGeneralRegisters + // pc, index, timers and V0-VF
+            kMemorySize +                               // memory
+            8 * kVerticalDisplaySize +                  // framebuffer rows
+            8 +                                         // random number generator
+            1 + 2 +                                     // trap flag and opcode
+            1 + 1;                                      // waiting for key flag and register
+
+        static std::unique_ptr<DisplayBackend> MakeDisplayBackend(const Frontend frontend)
+        {
+            if (frontend == Frontend::kHeadless)
+            {
+                return std::make_unique<HeadlessDisplayBackend>();
+            }
+
+            return std::make_unique<SdlDisplayBackend>();
+        }
+
+        //
+        // Fetch the instruction at pc and advance pc.
+        // Only decode it if it's not in the decode cache already.
+        //
+        const DecodedInstruction& Fetch()
+        {
+            const auto pc = registers_.pc;
+            if (const auto cached = decode_cache_.Find(pc))
+            {
+                registers_.pc += 2;
+                return *cached;
+            }
+
+            const Opcode opcode = memory_.FetchOpcode(registers_.pc);
+            return decode_cache_.Insert(pc, DecodedInstruction::From(opcode, LookupInstruction(opcode.Value())));
+        }
+
+        static constexpr std::array<DispatchEntry, 0x10000> BuildDispatchTable()
+        {
+            std::array<DispatchEntry, 0x10000> table{};
+            for (uint32_t opcode = 0; opcode < table.size(); opcode++)
+            {
+                const auto instruction = Decoder::Decode(static_cast<OpcodeType>(opcode));
+                table[opcode] = { HandlerFor(instruction), instruction, InstructionIndex(instruction) };
+            }
+
+            return table;
+        }
+
+        static constexpr InstructionHandler HandlerFor(const Instruction instruction)
+        {
+            switch (instruction)
+            {
+            case Instruction::kSys:
+                return &Handle<Instruction::kSys>;
+            case Instruction::kClearScreen:
+                return &Handle<Instruction::kClearScreen>;
+            case Instruction::kReturn:
+                return &Handle<Instruction::kReturn>;
+            case Instruction::kJump:
+                return &Handle<Instruction::kJump>;
+            case Instruction::kCall:
+                return &Handle<Instruction::kCall>;
+            case Instruction::kSkipNextInstructionIfEq:
+                return &Handle<Instruction::kSkipNextInstructionIfEq>;
+            case Instruction::kSkipNextInstructionIfNotEq:
+                return &Handle<Instruction::kSkipNextInstructionIfNotEq>;
+            case Instruction::kSkipNextInstructionIfXEqY:
+                return &Handle<Instruction::kSkipNextInstructionIfXEqY>;
+            case Instruction::kSetVxRegister:
+                return &Handle<Instruction::kSetVxRegister>;
+            case Instruction::kAddToRegister:
+                return &Handle<Instruction::kAddToRegister>;
+            case Instruction::kSetVxVy:
+                return &Handle<Instruction::kSetVxVy>;
+            case Instruction::kOrVxVy:
+                return &Handle<Instruction::kOrVxVy>;
+            case Instruction::kAndVxVy:
+                return &Handle<Instruction::kAndVxVy>;
+            case Instruction::kXorVxVy:
+                return &Handle<Instruction::kXorVxVy>;
+            case Instruction::kAddVxVy:
+                return &Handle<Instruction::kAddVxVy>;
+            case Instruction::kSubVxVy:
+                return &Handle<Instruction::kSubVxVy>;
+            case Instruction::kShrVxVy:
+                return &Handle<Instruction::kShrVxVy>;
+            case Instruction::kSubnVxVy:
+                return &Handle<Instruction::kSubnVxVy>;
+            case Instruction::kShlVxVy:
+                return &Handle<Instruction::kShlVxVy>;
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+                return &Handle<Instruction::kSkipNextInstructionIfXNotEqY>;
+            case Instruction::kSetIndexRegister:
+                return &Handle<Instruction::kSetIndexRegister>;
+            case Instruction::kJumpOffset:
+                return &Handle<Instruction::kJumpOffset>;
+            case Instruction::kRandom:
+                return &Handle<Instruction::kRandom>;
+            case Instruction::kDraw:
+                return &Handle<Instruction::kDraw>;
+            case Instruction::kSkipIfPressed:
+                return &Handle<Instruction::kSkipIfPressed>;
+            case Instruction::kSkipIfNotPressed:
+                return &Handle<Instruction::kSkipIfNotPressed>;
+            case Instruction::kStoreDelayTimer:
+                return &Handle<Instruction::kStoreDelayTimer>;
+            case Instruction::kStoreKeyPress:
+                return &Handle<Instruction::kStoreKeyPress>;
+            case Instruction::kSetDelayTimer:
+                return &Handle<Instruction::kSetDelayTimer>;
+            case Instruction::kSetSoundTimer:
+                return &Handle<Instruction::kSetSoundTimer>;
+            case Instruction::kAddIVx:
+                return &Handle<Instruction::kAddIVx>;
+            case Instruction::kSetSpriteFromVx:
+                return &Handle<Instruction::kSetSpriteFromVx>;
+            case Instruction::kStoreBcdFromVx:
+                return &Handle<Instruction::kStoreBcdFromVx>;
+            case Instruction::kStoreRegisters:
+                return &Handle<Instruction::kStoreRegisters>;
+            case Instruction::kSetRegisters:
+                return &Handle<Instruction::kSetRegisters>;
+            default:
+                return &Handle<Instruction::kInvalid>;
+            }
+        }
+
+        template <Instruction kInstruction>
+        static void Handle(Machine& machine, const DecodedInstruction& decoded)
+        {
+            machine.Emulate<kInstruction>(decoded);
+        }
+
+        //
+        // Count both timers down by one, called once per emulated 60Hz frame.
+        //
+        void TickTimers()
+        {
+            if (registers_.delay_timer != 0)
+            {
+                registers_.delay_timer -= 1;
+            }
+
+            if (registers_.sound_timer != 0)
+            {
+                registers_.sound_timer -= 1;
+                speaker_.Play(true);
+            }
+            else
+            {
+                speaker_.Play(false);
+            }
+        }
+
+        //
+        // The cores stop executing when an opcode traps, FX0A starts waiting,
+        // checked memory faults or a jump closes what looks like an idle loop.
+        //
+        bool IsStopped() const
+        {
+            return is_trapped_ || is_waiting_for_key_ || is_idle_ || memory_.HasFault();
+        }
+
+        //
+        // Idle loops are short, so they end in a short backward jump. One made of
+        // nothing but the instructions below might be one, Cpu::SkipIdleLoop makes sure.
+        // The answer is kept for the last jump seen, which is the same one while a loop runs.
+        //
+        void ProbeIdleLoop(const uint16_t jump, const uint16_t target)
+        {
+            if (jump != idle_jump_)
+            {
+                idle_jump_ = jump;
+                is_idle_jump_ = true;
+                for (auto pc = target; pc < jump; pc += 2)
+                {
+                    const auto opcode = static_cast<OpcodeType>(memory_.Data()[pc] << 8 | memory_.Data()[pc + 1]);
+                    is_idle_jump_ = is_idle_jump_ && IsIdleLoopInstruction(Decoder::Decode(opcode));
+                }
+            }
+
+            is_idle_ = is_idle_jump_;
+        }
+
+        static bool IsIdleLoopInstruction(const Instruction instruction)
+        {
+            switch (instruction)
+            {
+            case Instruction::kJump:
+            case Instruction::kSetVxRegister:
+            case Instruction::kSkipNextInstructionIfEq:
+            case Instruction::kSkipNextInstructionIfNotEq:
+            case Instruction::kSkipNextInstructionIfXEqY:
+            case Instruction::kSkipNextInstructionIfXNotEqY:
+            case Instruction::kSkipIfPressed:
+            case Instruction::kSkipIfNotPressed:
+            case Instruction::kStoreDelayTimer:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        //
+        // Finish a pending FX0A with the lowest pressed key.
+        //
+        void ResumeIfKeyPressed()
+        {
+            if (is_waiting_for_key_ && keys_ != 0)
+            {
+                registers_.v[key_register_] = static_cast<uint8_t>(std::countr_zero(keys_));
+                is_waiting_for_key_ = false;
+            }
+        }
+
+        bool IsKeyPressed(const uint8_t key) const
+        {
+            if (key >= kNumberOfKeys)
+            {
+                throw std::runtime_error{ std::format("Could not find {:#x} key", key) };
+            }
+
+            return (keys_ >> key) & 1;
+        }
+
+        //
+        // Invalid and unimplemented opcodes end up here.
+        // Stop the CPU and let Run report the opcode, off the hot path.
+        //
+        void Trap(const DecodedInstruction& decoded)
+        {
+            trap_opcode_ = decoded.opcode;
+            is_trapped_ = true;
+        }
+
+        template <Instruction kInstruction>
+        void Emulate(const DecodedInstruction& decoded)
+        {
+            if constexpr (kInstruction == Instruction::kReturn)
+            {
+                registers_.pc = stack_.pop();
+            }
+            else if constexpr (kInstruction == Instruction::kClearScreen)
+            {
+                display_.Clear();
+            }
+            else if constexpr (kInstruction == Instruction::kJump)
+            {
+                const auto jump = static_cast<uint16_t>(registers_.pc - 2);
+                registers_.pc = decoded.nnn;
+
+                if (is_idle_loop_skipping_ && decoded.nnn <= jump && jump - decoded.nnn < 2 * kMaxIdleLoopLength)
+                {
+                    ProbeIdleLoop(jump, decoded.nnn);
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kCall)
+            {
+                stack_.push(registers_.pc);
+                registers_.pc = decoded.nnn;
+            }
+            else if constexpr (kInstruction == Instruction::kSetVxRegister)
+            {
+                registers_.v[decoded.x] = decoded.nn;
+            }
+            else if constexpr (kInstruction == Instruction::kAddToRegister)
+            {
+                registers_.v[decoded.x] += decoded.nn;
+            }
+            else if constexpr (kInstruction == Instruction::kSetVxVy)
+            {
+                registers_.v[decoded.x] = registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kOrVxVy)
+            {
+                registers_.v[decoded.x] |= registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kAndVxVy)
+            {
+                registers_.v[decoded.x] &= registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kXorVxVy)
+            {
+                registers_.v[decoded.x] ^= registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kAddVxVy)
+            {
+                if ((registers_.v[decoded.x] + registers_.v[decoded.y]) > 255)
+                {
+                    registers_.v[0xF] = 0x1;
+                }
+                else
+                {
+                    registers_.v[0xF] = 0x0;
+                }
+
+                registers_.v[decoded.x] += registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kSubVxVy)
+            {
+                if (registers_.v[decoded.x] >= registers_.v[decoded.y])
+                {
+                    registers_.v[0xF] = 0x1;
+                }
+                else
+                {
+                    registers_.v[0xF] = 0x0;
+                }
+
+                registers_.v[decoded.x] = registers_.v[decoded.x] - registers_.v[decoded.y];
+            }
+            else if constexpr (kInstruction == Instruction::kSubnVxVy)
+            {
+                if (registers_.v[decoded.y] >= registers_.v[decoded.x])
+                {
+                    registers_.v[0xF] = 0x1;
+                }
+                else
+                {
+                    registers_.v[0xF] = 0x0;
+                }
+
+                registers_.v[decoded.x] = registers_.v[decoded.y] - registers_.v[decoded.x];
+            }
+            else if constexpr (kInstruction == Instruction::kShrVxVy)
+            {
+                if (registers_.v[decoded.x] & 0x1)
+                {
+                    registers_.v[0xF] = 0x1;
+                }
+                else
+                {
+                    registers_.v[0xF] = 0x0;
+                }
+
+                registers_.v[decoded.x] >>= 1;
+            }
+            else if constexpr (kInstruction == Instruction::kShlVxVy)
+            {
+                if (registers_.v[decoded.x] & 0x80)
+                {
+                    registers_.v[0xF] = 0x1;
+                }
+                else
+                {
+                    registers_.v[0xF] = 0x0;
+                }
+
+                registers_.v[decoded.x] <<= 1;
+            }
+            else if constexpr (kInstruction == Instruction::kSetIndexRegister)
+            {
+                registers_.index = decoded.nnn;
+            }
+            else if constexpr (kInstruction == Instruction::kJumpOffset)
+            {
+                registers_.pc = decoded.nnn + registers_.v[0];
+            }
+            else if constexpr (kInstruction == Instruction::kRandom)
+            {
+                registers_.v[decoded.x] = rng_.NextByte() & decoded.nn;
+            }
+            else if constexpr (kInstruction == Instruction::kDraw)
+            {
+                const uint8_t* sprite = memory_.View(registers_.index, decoded.n);
+                const auto pixel_turned_off = display_.Draw(registers_.v[decoded.x], registers_.v[decoded.y], sprite, decoded.n);
+                registers_.v[0xF] = pixel_turned_off ? 0x1 : 0x0;
+            }
+            else if constexpr (kInstruction == Instruction::kSkipNextInstructionIfEq)
+            {
+                if (registers_.v[decoded.x] == decoded.nn)
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSkipNextInstructionIfNotEq)
+            {
+                if (registers_.v[decoded.x] != decoded.nn)
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSkipNextInstructionIfXEqY)
+            {
+                if (registers_.v[decoded.x] == registers_.v[decoded.y])
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSkipNextInstructionIfXNotEqY)
+            {
+                if (registers_.v[decoded.x] != registers_.v[decoded.y])
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSkipIfPressed)
+            {
+                if (IsKeyPressed(registers_.v[decoded.x]))
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSkipIfNotPressed)
+            {
+                if (!IsKeyPressed(registers_.v[decoded.x]))
+                {
+                    registers_.pc += 2;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kStoreDelayTimer)
+            {
+                registers_.v[decoded.x] = registers_.delay_timer;
+            }
+            else if constexpr (kInstruction == Instruction::kStoreKeyPress)
+            {
+                //
+                // Keys only change between frames. If none is pressed now
+                // stop executing until one is, see ResumeIfKeyPressed.
+                //
+                if (keys_ != 0)
+                {
+                    registers_.v[decoded.x] = static_cast<uint8_t>(std::countr_zero(keys_));
+                }
+                else
+                {
+                    is_waiting_for_key_ = true;
+                    key_register_ = decoded.x;
+                }
+            }
+            else if constexpr (kInstruction == Instruction::kSetDelayTimer)
+            {
+                registers_.delay_timer = registers_.v[decoded.x];
+            }
+            else if constexpr (kInstruction == Instruction::kSetSoundTimer)
+            {
+                registers_.sound_timer = registers_.v[decoded.x];
+            }
+            else if constexpr (kInstruction == Instruction::kAddIVx)
+            {
+                registers_.index = registers_.index + registers_.v[decoded.x];
+            }
+            else if constexpr (kInstruction == Instruction::kSetSpriteFromVx)
+            {
+                registers_.index = kSpritesAddress + kSpriteSize * registers_.v[decoded.x];
+            }
+            else if constexpr (kInstruction == Instruction::kStoreBcdFromVx)
+            {
+                const auto value = registers_.v[decoded.x];
+                const uint8_t digits[] = {
+                    static_cast<uint8_t>(value / 100),
+                    static_cast<uint8_t>(value / 10 % 10),
+                    static_cast<uint8_t>(value % 10),
+                };
+                memory_.Write(digits, sizeof(digits), registers_.index);
+            }
+            else if constexpr (kInstruction == Instruction::kStoreRegisters)
+            {
+                memory_.StoreRegisters(registers_.v, decoded.x + 1, registers_.index);
+            }
+            else if constexpr (kInstruction == Instruction::kSetRegisters)
+            {
+                memory_.LoadRegisters(registers_.index, registers_.v, decoded.x + 1);
+            }
+            else
+            {
+                Trap(decoded);
+            }
+        }
+
+        Registers registers_{ 0x00 };
+        DecodeCache decode_cache_;
+        Stack stack_;
+        Memory<> memory_;
+        Display display_;
+        Keyboard keyboard_;
+        uint16_t keys_ = 0;
+        Speaker speaker_;
+        Rng rng_;
+        uint32_t seed_ = Rng::kDefaultSeed;
+
+        //
+        // Set once an opcode traps.
+        //
+        bool is_trapped_ = false;
+        Opcode trap_opcode_{};
+
+        //
+        // Set by FX0A until a key is pressed, then the key goes to V[key_register_].
+        //
+        bool is_waiting_for_key_ = false;
+        uint8_t key_register_ = 0;
+
+        //
+        // See ProbeIdleLoop. is_idle_ is only ever set until Cpu::Execute checks the loop.
+        //
+        static constexpr uint16_t kNoIdleJump = 0xFFFF;
+
+        bool is_idle_loop_skipping_ = true;
+        bool is_idle_ = false;
+        uint16_t idle_jump_ = kNoIdleJump;
+        bool is_idle_jump_ = false;
+    };
+
+    //
+    // Defined out of line, the table can only be built once Machine is complete.
+    //
+    inline const DispatchEntry& Machine::LookupInstruction(const OpcodeType opcode)
+    {
+        static constexpr auto kDispatchTable = BuildDispatchTable();
+        return kDispatchTable[opcode];
+    }
+}
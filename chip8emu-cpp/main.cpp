@@ -1,27 +1,301 @@
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <string>
+#include <string_view>
 
 #include "cpu.hpp"
+#include "movie.hpp"
 
-int main(int argc, char** argv)
+struct Options
+{
+    std::string rom_path;
+    std::string trace_path;
+
+    //
+    // Savestate to start from, and where to write one once a turbo run finishes.
+    //
+    std::string load_state_path;
+    std::string save_state_path;
+
+    //
+    // Movie to record the keys of a windowed run to, or to replay headless.
+    //
+    std::string record_path;
+    std::string replay_path;
+    uint32_t seed = chip8_emu::Rng::kDefaultSeed;
+
+    chip8_emu::CpuCore core = chip8_emu::CpuCore::kHandlerTable;
+    uint32_t instructions_per_frame = chip8_emu::kDefaultInstructionsPerFrame;
+
+    //
+    // Turbo runs a fixed number of frames headless, with no pacing.
+    //
+    bool is_turbo = false;
+    uint64_t turbo_frames = 3600;
+};
+
+static bool ParseOptions(const int argc, char** argv, Options& options)
 {
     if (argc < 2)
     {
-        std::cout << std::format("Usage: {} <rom_file>", argv[0]);
-        return 1;
+        return false;
+    }
+
+    options.rom_path = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+
+        if (arg == "--turbo")
+        {
+            options.is_turbo = true;
+        }
+        else if (arg == "--frames" && has_value)
+        {
+            options.turbo_frames = std::stoull(argv[++i]);
+        }
+        else if (arg == "--ipf" && has_value)
+        {
+            options.instructions_per_frame = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--trace" && has_value)
+        {
+            options.trace_path = argv[++i];
+        }
+        else if (arg == "--load-state" && has_value)
+        {
+            options.load_state_path = argv[++i];
+        }
+        else if (arg == "--save-state" && has_value)
+        {
+            options.save_state_path = argv[++i];
+        }
+        else if (arg == "--record" && has_value)
+        {
+            options.record_path = argv[++i];
+        }
+        else if (arg == "--replay" && has_value)
+        {
+            options.replay_path = argv[++i];
+        }
+        else if (arg == "--seed" && has_value)
+        {
+            options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--core" && has_value)
+        {
+            const std::string_view core = argv[++i];
+            if (core == "table")
+            {
+                options.core = chip8_emu::CpuCore::kHandlerTable;
+            }
+            else if (core == "threaded")
+            {
+                options.core = chip8_emu::CpuCore::kThreaded;
+            }
+            else if (core == "jit")
+            {
+                options.core = chip8_emu::CpuCore::kJit;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    //
+    // Movies start from power on, and only windowed runs have keys to record.
+    //
+    const bool has_movie = !options.record_path.empty() || !options.replay_path.empty();
+    if (has_movie && !options.load_state_path.empty())
+    {
+        return false;
+    }
+
+    if (!options.record_path.empty() && (options.is_turbo || !options.replay_path.empty()))
+    {
+        return false;
+    }
+
+    //
+    // Only turbo runs save a state when they finish, replays take precedence over turbo.
+    //
+    if (!options.save_state_path.empty() && (!options.is_turbo || !options.replay_path.empty()))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io)
+    {
+        throw std::runtime_error{ std::format("Could not open {}", path) };
     }
 
-    std::ifstream io(argv[1], std::ios::binary | std::ios::ate);
     const auto size = io.tellg();
     io.seekg(0, std::ios::beg);
 
-    std::vector<uint8_t> program(size);
-    io.read((char*)program.data(), size);
+    std::vector<uint8_t> bytes(size);
+    io.read((char*)bytes.data(), size);
+
+    return bytes;
+}
+
+static void WriteFile(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    std::ofstream io(path, std::ios::binary);
+    io.write((const char*)bytes.data(), bytes.size());
+    if (!io)
+    {
+        throw std::runtime_error{ std::format("Could not write {}", path) };
+    }
+}
+
+//
+// Say why a headless run ended before its last frame, if it did.
+//
+template <typename CpuType>
+static void ReportStop(const CpuType& cpu)
+{
+    if (cpu.GetMemory().HasFault())
+    {
+        std::cout << std::format("Stopped at memory fault: {}\n", cpu.GetMemory().GetFault().ToString());
+    }
+    else if (cpu.IsTrapped())
+    {
+        std::cout << std::format("Stopped at invalid instruction {}\n", cpu.GetTrapOpcode().ToString());
+    }
+}
+
+//
+// Run as fast as the host allows and report how fast that was.
+//
+template <typename CpuType>
+static void RunTurbo(CpuType& cpu, const Options& options)
+{
+    uint64_t executed = 0;
+    uint64_t frames = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    while (frames < options.turbo_frames && !cpu.IsTrapped() && !cpu.GetMemory().HasFault())
+    {
+        executed += cpu.RunFrame(options.instructions_per_frame);
+        frames++;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto seconds = std::max(std::chrono::duration<double>(end - start).count(), 1e-9);
+    std::cout << std::format("Executed {} instructions in {} frames, {:.3f}s\n", executed, frames, seconds);
+    std::cout << std::format("{:.0f} instructions per second, {:.0f} frames per second\n", executed / seconds, frames / seconds);
+
+    ReportStop(cpu);
+}
+
+//
+// Replay a movie headless, as fast as the host allows.
+// The final framebuffer hash identifies the run.
+//
+template <typename CpuType>
+static void RunReplay(CpuType& cpu, const std::vector<uint8_t>& program, const Options& options)
+{
+    const auto movie = chip8_emu::LoadMovie(options.replay_path);
+    if (movie.rom_hash != chip8_emu::HashRom(program))
+    {
+        throw std::runtime_error{ std::format("{} was recorded with another ROM", options.replay_path) };
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto frames = chip8_emu::ReplayMovie(cpu, movie);
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto seconds = std::max(std::chrono::duration<double>(end - start).count(), 1e-9);
+    std::cout << std::format("Replayed {} of {} frames in {:.3f}s\n", frames, movie.keys.size(), seconds);
+    std::cout << std::format("Framebuffer hash {:#018x}\n", cpu.GetFramebuffer().Hash());
+
+    ReportStop(cpu);
+}
+
+template <typename CpuType>
+static void Start(CpuType& cpu, const std::vector<uint8_t>& program, const Options& options)
+{
+    cpu.Load(program);
+
+    cpu.Seed(options.seed);
+
+    if (!options.load_state_path.empty())
+    {
+        cpu.LoadState(ReadFile(options.load_state_path));
+    }
+
+    if (!options.replay_path.empty())
+    {
+        RunReplay(cpu, program, options);
+    }
+    else if (options.is_turbo)
+    {
+        RunTurbo(cpu, options);
+
+        if (!options.save_state_path.empty())
+        {
+            WriteFile(options.save_state_path, cpu.SaveState());
+        }
+    }
+    else if (!options.record_path.empty())
+    {
+        chip8_emu::MovieRecorder recorder{ options.record_path, chip8_emu::HashRom(program), options.seed, options.instructions_per_frame };
+        cpu.Run(options.instructions_per_frame, [&]() { recorder.Record(cpu.GetKeys()); });
+    }
+    else
+    {
+        cpu.Run(options.instructions_per_frame);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!ParseOptions(argc, argv, options))
+        {
+            throw std::invalid_argument{ "invalid arguments" };
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cout << std::format(
+            "Usage: {} <rom_file> [--core table|threaded|jit] [--ipf <instructions_per_frame>] "
+            "[--trace <trace_file>] [--seed <seed>] [--load-state <state_file>] [--turbo [--frames <frames>] [--save-state <state_file>]] "
+            "[--record <movie_file> | --replay <movie_file>]", argv[0]);
+        return 1;
+    }
 
     try
     {
-        chip8_emu::Cpu cpu;
-        cpu.Load(program);
-        cpu.Run();
+        const auto program = ReadFile(options.rom_path);
+        const auto is_headless = options.is_turbo || !options.replay_path.empty();
+        const auto frontend = is_headless ? chip8_emu::Frontend::kHeadless : chip8_emu::Frontend::kWindowed;
+        if (!options.trace_path.empty())
+        {
+            chip8_emu::Cpu<chip8_emu::BinaryTrace> cpu(options.core, frontend, options.trace_path);
+            Start(cpu, program, options);
+        }
+        else
+        {
+            chip8_emu::Cpu<> cpu(options.core, frontend);
+            Start(cpu, program, options);
+        }
     }
     catch (const std::exception& err)
     {
@@ -1,18 +1,137 @@
 #pragma once
-#include <cstring>
 
-#include <vector>
-#include <stdexcept>
-#include <format>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CHIP8_HAS_SSE2
+#include <immintrin.h>
+#endif
 
 #include "constants.hpp"
+#include "decode_cache.hpp"
+#include "code_map.hpp"
+#include "savestate.hpp"
 
 namespace chip8_emu
 {
-    class Memory
+    //
+    // Access that ran past the end of memory.
+    //
+    struct MemoryFault
+    {
+        uint16_t address = 0;
+        uint16_t size = 0;
+        bool is_write = false;
+
+        std::string ToString() const
+        {
+            return std::format("{} of {} bytes at {:#05x}", is_write ? "Write" : "Read", size, address);
+        }
+    };
+
+    //
+    // Memory access policies, they decide what happens to accesses that run past
+    // the end of memory. Neither of them ever throws.
+    //
+
+    //
+    // Addresses wrap around at 4K like they did on the original interpreters,
+    // so there's nothing to check and accesses never fault.
+    //
+    class WrappedAccess
+    {
+    public:
+        static constexpr bool HasFault()
+        {
+            return false;
+        }
+
+        static constexpr MemoryFault GetFault()
+        {
+            return {};
+        }
+
+        static constexpr void ClearFault()
+        {
+        }
+
+    protected:
+        static constexpr bool Check(const uint16_t, const size_t, const bool)
+        {
+            return true;
+        }
+    };
+
+    //
+    // For debugging. Accesses past the end of memory are not performed: reads
+    // see zeros and writes are dropped. The first one is kept in a fault register
+    // until ClearFault, and the machine stops executing while it's set.
+    //
+    class CheckedAccess
+    {
+    public:
+        bool HasFault() const
+        {
+            return has_fault_;
+        }
+
+        const MemoryFault& GetFault() const
+        {
+            return fault_;
+        }
+
+        void ClearFault()
+        {
+            has_fault_ = false;
+        }
+
+    protected:
+        bool Check(const uint16_t address, const size_t size, const bool is_write)
+        {
+            if (address + size <= kMemorySize)
+            {
+                return true;
+            }
+
+            if (!has_fault_)
+            {
+                fault_ = MemoryFault{ address, static_cast<uint16_t>(size), is_write };
+                has_fault_ = true;
+            }
+
+            return false;
+        }
+
+    private:
+        MemoryFault fault_{};
+        bool has_fault_ = false;
+    };
+
+    //
+    // Debug builds check every access.
+    //
+#if defined(CHIP8_CHECKED_MEMORY)
+    using DefaultMemoryAccess = CheckedAccess;
+#else
+    using DefaultMemoryAccess = WrappedAccess;
+#endif
+
+    template <typename AccessPolicy = DefaultMemoryAccess>
+    class Memory : public AccessPolicy
     {
     public:
+        //
+        // Largest block View hands out.
+        //
+        static constexpr size_t kMaxViewSize = 0x10;
+
         Memory() = default;
 
         Memory(const Memory&) = delete;
@@ -23,16 +142,32 @@ namespace chip8_emu
 
         ~Memory() = default;
 
-        void* Data(const uint16_t offset = 0x00)
+        //
+        // Every write is forwarded to the decode cache so stale
+        // instructions are decoded again before being executed.
+        //
+        void AttachDecodeCache(DecodeCache* decode_cache)
         {
-            if (offset >= kMemorySize)
-            {
-                throw std::runtime_error{ std::format("Could not access memory at offset {}, there's only {} bytes of memory", offset, kMemorySize) };
-            }
+            decode_cache_ = decode_cache;
+        }
 
-            return &data_[offset];
+        //
+        // Same for the JIT, which has to drop translated code that's overwritten.
+        //
+        void AttachCodeMap(CodeMap* code_map)
+        {
+            code_map_ = code_map;
+        }
+
+        const uint8_t* Data() const
+        {
+            return data_;
         }
 
+        //
+        // Load a program. A program that doesn't fit is an error of the host,
+        // not of the emulated machine, so this one always throws.
+        //
         void Write(const std::vector<uint8_t>& bytes, const uint16_t offset = 0x00)
         {
             if (offset + bytes.size() > kMemorySize)
@@ -41,46 +176,217 @@ namespace chip8_emu
             }
 
             std::memcpy(&data_[offset], bytes.data(), bytes.size());
+            InvalidateCode(offset, bytes.size());
         }
 
         void Write(const uint8_t byte, const uint16_t address)
         {
-            if (address >= kMemorySize)
+            if (!this->Check(address, 1, true))
             {
-                throw std::runtime_error{ "Memory out of bounds" };
+                return;
             }
 
-            data_[address] = byte;
+            const auto masked = static_cast<uint16_t>(address & kAddressMask);
+            data_[masked] = byte;
+            InvalidateCode(masked, 1);
         }
 
-        uint8_t Read(const uint16_t address) const
+        void Write(const uint8_t* bytes, const size_t size, const uint16_t address)
         {
-            if (address >= kMemorySize)
+            if (!this->Check(address, size, true))
             {
-                throw std::runtime_error{ "Memory out of bounds" };
+                return;
             }
 
-            return data_[address];
+            CopyIn(static_cast<uint16_t>(address & kAddressMask), bytes, size);
         }
 
-        Opcode FetchOpcode(uint16_t& pc) const
+        uint8_t Read(const uint16_t address)
         {
-            if (pc >= kMemorySize || pc + 1 >= kMemorySize)
+            if (!this->Check(address, 1, false))
             {
-                throw std::runtime_error{ std::format("Can't fetch opcode at offset {}, there's only {} bytes of memory", pc, kMemorySize) };
+                return 0;
             }
 
+            return data_[address & kAddressMask];
+        }
+
+        void Read(const uint16_t address, uint8_t* bytes, const size_t size)
+        {
+            if (!this->Check(address, size, false))
+            {
+                std::memset(bytes, 0, size);
+                return;
+            }
+
+            CopyOut(static_cast<uint16_t>(address & kAddressMask), bytes, size);
+        }
+
+        //
+        // FX55: store V0 through V(count - 1) at address.
+        // Unless the 16 bytes from address wrap around, that's a single 16-byte
+        // load, blend and store instead of a variable length copy.
+        //
+        void StoreRegisters(const uint8_t (&v)[kNumberOfGeneralRegisters], const uint8_t count, const uint16_t address)
+        {
+            if (!this->Check(address, count, true))
+            {
+                return;
+            }
+
+            const auto start = static_cast<uint16_t>(address & kAddressMask);
+#if defined(CHIP8_HAS_SSE2)
+            if (start + kNumberOfGeneralRegisters <= kMemorySize)
+            {
+                const auto target = reinterpret_cast<__m128i*>(&data_[start]);
+                _mm_storeu_si128(target, Blend(RegisterMask(count), _mm_loadu_si128(reinterpret_cast<const __m128i*>(v)), _mm_loadu_si128(target)));
+                InvalidateCode(start, count);
+                return;
+            }
+#endif
+            CopyIn(start, v, count);
+        }
+
+        //
+        // FX65: load V0 through V(count - 1) from address, same as StoreRegisters.
+        //
+        void LoadRegisters(const uint16_t address, uint8_t (&v)[kNumberOfGeneralRegisters], const uint8_t count)
+        {
+            if (!this->Check(address, count, false))
+            {
+                std::memset(v, 0, count);
+                return;
+            }
+
+            const auto start = static_cast<uint16_t>(address & kAddressMask);
+#if defined(CHIP8_HAS_SSE2)
+            if (start + kNumberOfGeneralRegisters <= kMemorySize)
+            {
+                const auto target = reinterpret_cast<__m128i*>(v);
+                _mm_storeu_si128(target, Blend(RegisterMask(count), _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data_[start])), _mm_loadu_si128(target)));
+                return;
+            }
+#endif
+            CopyOut(start, v, count);
+        }
+
+        //
+        // size bytes starting at address, at most kMaxViewSize of them.
+        // Points into memory unless the block wraps around, then it's a copy
+        // that stays valid until the next call.
+        //
+        const uint8_t* View(const uint16_t address, const size_t size)
+        {
+            if (!this->Check(address, size, false))
+            {
+                std::memset(view_, 0, size);
+                return view_;
+            }
+
+            const auto start = static_cast<uint16_t>(address & kAddressMask);
+            if (start + size <= kMemorySize)
+            {
+                return &data_[start];
+            }
+
+            CopyOut(start, view_, size);
+            return view_;
+        }
+
+        Opcode FetchOpcode(uint16_t& pc)
+        {
             Opcode opcode;
+            if (!this->Check(pc, 2, false))
+            {
+                pc += 2;
+                return opcode;
+            }
 
-            opcode.first_byte = data_[pc];
-            opcode.second_byte = data_[pc + 1];
+            const auto address = static_cast<uint16_t>(pc & kAddressMask);
+            opcode.first_byte = data_[address];
+            opcode.second_byte = data_[(address + 1) & kAddressMask];
 
-            pc += 2;
+            pc = address + 2;
 
             return opcode;
         }
 
+        void SaveState(StateWriter& writer) const
+        {
+            writer.WriteBytes(data_, kMemorySize);
+        }
+
+        void LoadState(StateReader& reader)
+        {
+            reader.ReadBytes(data_, kMemorySize);
+            InvalidateCode(0x00, kMemorySize);
+        }
+
     private:
+        static constexpr uint16_t kAddressMask = kMemorySize - 1;
+        static_assert((kMemorySize & kAddressMask) == 0, "Memory size must be a power of two");
+
+        //
+        // Block copies from and to memory, wrapping around its end.
+        //
+        void CopyOut(const uint16_t start, uint8_t* bytes, const size_t size) const
+        {
+            const auto head = std::min<size_t>(size, kMemorySize - start);
+            std::memcpy(bytes, &data_[start], head);
+            std::memcpy(bytes + head, &data_[0], size - head);
+        }
+
+        void CopyIn(const uint16_t start, const uint8_t* bytes, const size_t size)
+        {
+            const auto head = std::min<size_t>(size, kMemorySize - start);
+            std::memcpy(&data_[start], bytes, head);
+            std::memcpy(&data_[0], bytes + head, size - head);
+
+            InvalidateCode(start, head);
+            InvalidateCode(0x00, size - head);
+        }
+
+#if defined(CHIP8_HAS_SSE2)
+        //
+        // All ones in the first count bytes.
+        //
+        static __m128i RegisterMask(const uint8_t count)
+        {
+            return _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(count)), _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        }
+
+        static __m128i Blend(const __m128i mask, const __m128i selected, const __m128i other)
+        {
+            return _mm_or_si128(_mm_and_si128(mask, selected), _mm_andnot_si128(mask, other));
+        }
+#endif
+
+        void InvalidateCode(const uint16_t address, const size_t size)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+
+            if (decode_cache_ != nullptr)
+            {
+                decode_cache_->Invalidate(address, size);
+            }
+
+            if (code_map_ != nullptr)
+            {
+                code_map_->Invalidate(address, size);
+            }
+        }
+
+        DecodeCache* decode_cache_ = nullptr;
+        CodeMap* code_map_ = nullptr;
+
+        //
+        // Holds blocks returned by View that wrap around.
+        //
+        uint8_t view_[kMaxViewSize] = {};
+
         uint8_t data_[kMemorySize] =
         {
             //
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "constants.hpp"
+#include "savestate.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Movies start with these bytes, followed by kMovieVersion.
+    //
+    constexpr uint8_t kMovieMagic[4] = { 'C', '8', 'M', 'V' };
+    constexpr uint16_t kMovieVersion = 1;
+
+    //
+    // A run of identical frames covers at most this many frames,
+    // so a recording cut short loses at most a second of input.
+    //
+    constexpr uint8_t kMaxMovieRun = kTimerFrequency;
+
+    //
+    // FNV-1a, used to check a movie is replayed with the ROM it was recorded with.
+    //
+    inline uint64_t HashRom(const std::vector<uint8_t>& rom)
+    {
+        uint64_t hash = 0xCBF29CE484222325ULL;
+        for (const auto byte : rom)
+        {
+            hash ^= byte;
+            hash *= 0x100000001B3ULL;
+        }
+
+        return hash;
+    }
+
+    //
+    // Everything needed to replay a run: the ROM it ran, the RNG seed,
+    // instructions per frame and the keys pressed on every frame.
+    //
+    struct Movie
+    {
+        uint64_t rom_hash = 0;
+        uint32_t seed = 0;
+        uint32_t instructions_per_frame = kDefaultInstructionsPerFrame;
+        std::vector<uint16_t> keys;
+    };
+
+    //
+    // Streams a movie to a file while it's recorded.
+    // After the header the file is a list of runs: 16-bit key bitmap, then
+    // the number of consecutive frames it was held for.
+    //
+    class MovieRecorder
+    {
+    public:
+        MovieRecorder(const std::string& path, const uint64_t rom_hash, const uint32_t seed, const uint32_t instructions_per_frame)
+            : io_{ path, std::ios::binary }
+        {
+            if (!io_)
+            {
+                throw std::runtime_error{ std::format("Could not create movie {}", path) };
+            }
+
+            std::vector<uint8_t> header;
+            StateWriter writer{ header };
+            writer.WriteBytes(kMovieMagic, sizeof(kMovieMagic));
+            writer.WriteU16(kMovieVersion);
+            writer.WriteU64(rom_hash);
+            writer.WriteU32(seed);
+            writer.WriteU32(instructions_per_frame);
+            Write(header);
+        }
+
+        MovieRecorder(const MovieRecorder&) = delete;
+        MovieRecorder(MovieRecorder&&) = delete;
+
+        MovieRecorder& operator=(const MovieRecorder&) = delete;
+        MovieRecorder& operator=(MovieRecorder&&) = delete;
+
+        ~MovieRecorder()
+        {
+            FlushRun();
+        }
+
+        //
+        // Record the keys held during the next frame.
+        //
+        void Record(const uint16_t keys)
+        {
+            if (run_frames_ != 0 && (keys != run_keys_ || run_frames_ == kMaxMovieRun))
+            {
+                FlushRun();
+            }
+
+            run_keys_ = keys;
+            run_frames_++;
+        }
+
+    private:
+        void FlushRun()
+        {
+            if (run_frames_ == 0)
+            {
+                return;
+            }
+
+            std::vector<uint8_t> run;
+            StateWriter writer{ run };
+            writer.WriteU16(run_keys_);
+            writer.WriteU8(run_frames_);
+            Write(run);
+
+            run_frames_ = 0;
+        }
+
+        void Write(const std::vector<uint8_t>& bytes)
+        {
+            io_.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            io_.flush();
+        }
+
+        std::ofstream io_;
+        uint16_t run_keys_ = 0;
+        uint8_t run_frames_ = 0;
+    };
+
+    inline Movie LoadMovie(const std::string& path)
+    {
+        std::ifstream io(path, std::ios::binary);
+        if (!io)
+        {
+            throw std::runtime_error{ std::format("Could not open movie {}", path) };
+        }
+
+        const std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>(io), std::istreambuf_iterator<char>() };
+        StateReader reader{ bytes.data(), bytes.size() };
+
+        uint8_t magic[sizeof(kMovieMagic)];
+        reader.ReadBytes(magic, sizeof(magic));
+        if (std::memcmp(magic, kMovieMagic, sizeof(magic)) != 0)
+        {
+            throw std::runtime_error{ std::format("{} is not a movie", path) };
+        }
+
+        const auto version = reader.ReadU16();
+        if (version != kMovieVersion)
+        {
+            throw std::runtime_error{ std::format("Unsupported movie version {}, expected {}", version, kMovieVersion) };
+        }
+
+        Movie movie;
+        movie.rom_hash = reader.ReadU64();
+        movie.seed = reader.ReadU32();
+        movie.instructions_per_frame = reader.ReadU32();
+
+        while (reader.GetRemaining() != 0)
+        {
+            const auto keys = reader.ReadU16();
+            const auto frames = reader.ReadU8();
+            movie.keys.insert(movie.keys.end(), frames, keys);
+        }
+
+        return movie;
+    }
+
+    //
+    // Replay a movie on a machine with the movie's ROM loaded.
+    // Stops early if an opcode traps or memory faults. Returns how many frames were run.
+    //
+    template <typename CpuType>
+    uint64_t ReplayMovie(CpuType& cpu, const Movie& movie)
+    {
+        cpu.Seed(movie.seed);
+
+        uint64_t frames = 0;
+        while (frames < movie.keys.size() && !cpu.IsTrapped() && !cpu.GetMemory().HasFault())
+        {
+            cpu.SetKeys(movie.keys[frames]);
+            cpu.RunFrame(movie.instructions_per_frame);
+            frames++;
+        }
+
+        return frames;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CHIP8_HAS_SSE2
+#include <immintrin.h>
+#endif
+
+#include "constants.hpp"
+#include "framebuffer.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Expand a framebuffer to 32-bit pixels, on_color where a pixel is lit and
+    // off_color elsewhere. Rows start pitch bytes apart, like in a locked SDL texture.
+    // Every sprite-sized byte of a row is turned into 8 pixels at once by testing
+    // each lane against its own bit, so there are no per-pixel branches.
+    //
+    inline void ExpandFramebuffer(const Framebuffer& frame, void* pixels, const size_t pitch, const uint32_t on_color, const uint32_t off_color)
+    {
+#if defined(__AVX2__)
+        const auto off = _mm256_set1_epi32(static_cast<int>(off_color));
+        const auto flip = _mm256_set1_epi32(static_cast<int>(on_color ^ off_color));
+        const auto bits = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+#elif defined(CHIP8_HAS_SSE2)
+        const auto off = _mm_set1_epi32(static_cast<int>(off_color));
+        const auto flip = _mm_set1_epi32(static_cast<int>(on_color ^ off_color));
+        const auto high_bits = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+        const auto low_bits = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+#endif
+
+        for (uint8_t y = 0; y < kVerticalDisplaySize; y++)
+        {
+            const auto row = frame.GetRow(y);
+            const auto out = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(pixels) + y * pitch);
+
+            for (uint8_t x = 0; x < kHorizontalDisplaySize; x += 8)
+            {
+                const auto byte = static_cast<int>((row >> (kHorizontalDisplaySize - 8 - x)) & 0xFF);
+#if defined(__AVX2__)
+                const auto lit = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte), bits), bits);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_xor_si256(off, _mm256_and_si256(flip, lit)));
+#elif defined(CHIP8_HAS_SSE2)
+                const auto value = _mm_set1_epi32(byte);
+                const auto high = _mm_cmpeq_epi32(_mm_and_si128(value, high_bits), high_bits);
+                const auto low = _mm_cmpeq_epi32(_mm_and_si128(value, low_bits), low_bits);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_xor_si128(off, _mm_and_si128(flip, high)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 4), _mm_xor_si128(off, _mm_and_si128(flip, low)));
+#else
+                for (uint8_t i = 0; i < 8; i++)
+                {
+                    out[x + i] = (byte >> (7 - i)) & 1 ? on_color : off_color;
+                }
+#endif
+            }
+        }
+    }
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+#include "constants.hpp"
+#include "savestate.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Keeps the most recent per-frame savestates in a fixed number of slots.
+    // Every keyframe_interval frames a full savestate is kept as a keyframe,
+    // the frames in between only keep the bytes that differ from their keyframe,
+    // XORed and run length encoded. Any of them is restored by decoding a single delta.
+    //
+    class RewindBuffer
+    {
+    public:
+        //
+        // Holds at least capacity frames once that many were pushed.
+        //
+        explicit RewindBuffer(const size_t capacity, const size_t keyframe_interval = kTimerFrequency)
+            : slots_(capacity + keyframe_interval)
+            , keyframe_interval_{ keyframe_interval }
+        {
+            if (capacity == 0 || keyframe_interval == 0)
+            {
+                throw std::runtime_error{ "Rewind buffer needs room for at least one frame" };
+            }
+        }
+
+        RewindBuffer(const RewindBuffer&) = delete;
+        RewindBuffer(RewindBuffer&&) = delete;
+
+        RewindBuffer& operator=(const RewindBuffer&) = delete;
+        RewindBuffer& operator=(RewindBuffer&&) = delete;
+
+        ~RewindBuffer() = default;
+
+        //
+        // Record the state of the frame that just finished.
+        //
+        void Push(const std::vector<uint8_t>& state)
+        {
+            if (state.size() > kMaxStateSize)
+            {
+                throw std::runtime_error{ std::format("Can't keep a {} byte state, the limit is {}", state.size(), kMaxStateSize) };
+            }
+
+            if (count_ == slots_.size())
+            {
+                EvictOldestKeyframe();
+            }
+
+            auto& slot = slots_[head_];
+            const bool is_keyframe = count_ == 0 ||
+                frames_since_keyframe_ >= keyframe_interval_ ||
+                slots_[keyframe_].data.size() != state.size();
+
+            slot.is_keyframe = is_keyframe;
+            if (is_keyframe)
+            {
+                slot.data.assign(state.begin(), state.end());
+                keyframe_ = head_;
+                frames_since_keyframe_ = 0;
+            }
+            else
+            {
+                EncodeDelta(state, slots_[keyframe_].data, slot.data);
+            }
+
+            slot.keyframe = keyframe_;
+            frames_since_keyframe_++;
+            head_ = Next(head_);
+            count_++;
+        }
+
+        //
+        // State from frames_ago frames before the newest one, which is 0.
+        //
+        std::vector<uint8_t> GetState(const size_t frames_ago) const
+        {
+            std::vector<uint8_t> state;
+            Decode(SlotFor(frames_ago), state);
+
+            return state;
+        }
+
+        //
+        // Go back frames_ago frames. Everything newer is dropped,
+        // so the returned state becomes the newest one.
+        //
+        std::vector<uint8_t> Rewind(const size_t frames_ago)
+        {
+            const auto slot = SlotFor(frames_ago);
+
+            std::vector<uint8_t> state;
+            Decode(slot, state);
+
+            head_ = Next(slot);
+            count_ -= frames_ago;
+            keyframe_ = slots_[slot].keyframe;
+            frames_since_keyframe_ = (slot + slots_.size() - keyframe_) % slots_.size() + 1;
+
+            return state;
+        }
+
+        size_t GetFrameCount() const
+        {
+            return count_;
+        }
+
+        //
+        // Bytes held by the stored frames.
+        //
+        size_t GetMemoryUsage() const
+        {
+            size_t usage = slots_.size() * sizeof(Slot);
+            for (const auto& slot : slots_)
+            {
+                usage += slot.data.capacity();
+            }
+
+            return usage;
+        }
+
+        void Clear()
+        {
+            head_ = 0;
+            count_ = 0;
+            frames_since_keyframe_ = 0;
+        }
+
+    private:
+        //
+        // Delta runs store offsets and lengths in 16 bits.
+        //
+        static constexpr size_t kMaxStateSize = 0xFFFF;
+
+        //
+        // Unchanged bytes shorter than a run header are cheaper to copy than to skip.
+        //
+        static constexpr size_t kMinSkip = 4;
+
+        struct Slot
+        {
+            // Full state for keyframes, XOR runs against slots_[keyframe] otherwise
+            std::vector<uint8_t> data;
+
+            // Keyframe this frame is encoded against, itself for keyframes
+            size_t keyframe = 0;
+
+            bool is_keyframe = false;
+        };
+
+        size_t Next(const size_t slot) const
+        {
+            return slot + 1 == slots_.size() ? 0 : slot + 1;
+        }
+
+        size_t SlotFor(const size_t frames_ago) const
+        {
+            if (frames_ago >= count_)
+            {
+                throw std::runtime_error{ std::format("Can't rewind {} frames, only {} are kept", frames_ago, count_) };
+            }
+
+            return (head_ + slots_.size() - 1 - frames_ago) % slots_.size();
+        }
+
+        //
+        // Deltas can't outlive their keyframe, drop the oldest keyframe together with them.
+        //
+        void EvictOldestKeyframe()
+        {
+            auto tail = (head_ + slots_.size() - count_) % slots_.size();
+            do
+            {
+                tail = Next(tail);
+                count_--;
+            } while (count_ != 0 && !slots_[tail].is_keyframe);
+        }
+
+        //
+        // Delta runs are: 16-bit count of unchanged bytes to skip, 16-bit count of
+        // changed bytes, then the changed bytes XORed with the keyframe.
+        //
+        static void EncodeDelta(const std::vector<uint8_t>& state, const std::vector<uint8_t>& keyframe, std::vector<uint8_t>& delta)
+        {
+            delta.clear();
+            StateWriter writer{ delta };
+
+            const auto size = state.size();
+            size_t position = 0;
+            while (true)
+            {
+                auto start = position;
+                while (start < size && state[start] == keyframe[start])
+                {
+                    start++;
+                }
+
+                if (start == size)
+                {
+                    break;
+                }
+
+                auto end = start;
+                for (size_t same = 0; end < size && same < kMinSkip; end++)
+                {
+                    same = state[end] == keyframe[end] ? same + 1 : 0;
+                    if (same == kMinSkip)
+                    {
+                        end -= kMinSkip - 1;
+                        break;
+                    }
+                }
+
+                writer.WriteU16(static_cast<uint16_t>(start - position));
+                writer.WriteU16(static_cast<uint16_t>(end - start));
+                for (auto i = start; i < end; i++)
+                {
+                    writer.WriteU8(state[i] ^ keyframe[i]);
+                }
+
+                position = end;
+            }
+        }
+
+        void Decode(const size_t slot, std::vector<uint8_t>& state) const
+        {
+            const auto& keyframe = slots_[slots_[slot].keyframe].data;
+            state.assign(keyframe.begin(), keyframe.end());
+            if (slots_[slot].is_keyframe)
+            {
+                return;
+            }
+
+            const auto& delta = slots_[slot].data;
+            StateReader reader{ delta.data(), delta.size() };
+
+            size_t position = 0;
+            while (reader.GetRemaining() != 0)
+            {
+                position += reader.ReadU16();
+                const auto length = reader.ReadU16();
+                for (size_t i = 0; i < length; i++, position++)
+                {
+                    state[position] ^= reader.ReadU8();
+                }
+            }
+        }
+
+        std::vector<Slot> slots_;
+        size_t keyframe_interval_;
+
+        //
+        // Next slot to write, and how many slots before it hold frames.
+        //
+        size_t head_ = 0;
+        size_t count_ = 0;
+
+        //
+        // Keyframe new deltas are encoded against.
+        //
+        size_t keyframe_ = 0;
+        size_t frames_since_keyframe_ = 0;
+    };
+}
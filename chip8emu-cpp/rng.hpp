@@ -0,0 +1,76 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "savestate.hpp"
+
+namespace chip8_emu
+{
+    //
+    // PCG32 (XSH RR) random number generator, what CXNN reads from.
+    // Every machine owns one, so instances never contend on shared state and
+    // a run is reproduced exactly by its seed. The whole state is one 64-bit
+    // word, which goes into savestates as is.
+    //
+    class Rng
+    {
+    public:
+        static constexpr uint32_t kDefaultSeed = 1;
+
+        explicit Rng(const uint32_t seed = kDefaultSeed)
+        {
+            Seed(seed);
+        }
+
+        Rng(const Rng&) = delete;
+        Rng(Rng&&) = delete;
+
+        Rng& operator=(const Rng&) = delete;
+        Rng& operator=(Rng&&) = delete;
+
+        ~Rng() = default;
+
+        void Seed(const uint32_t seed)
+        {
+            state_ = 0;
+            Next();
+            state_ += seed;
+            Next();
+        }
+
+        uint32_t Next()
+        {
+            const auto state = state_;
+            state_ = state * kMultiplier + kIncrement;
+
+            const auto xorshifted = static_cast<uint32_t>(((state >> 18) ^ state) >> 27);
+            const auto rotation = static_cast<int>(state >> 59);
+            return std::rotr(xorshifted, rotation);
+        }
+
+        //
+        // The high bits are the best distributed ones.
+        //
+        uint8_t NextByte()
+        {
+            return static_cast<uint8_t>(Next() >> 24);
+        }
+
+        void SaveState(StateWriter& writer) const
+        {
+            writer.WriteU64(state_);
+        }
+
+        void LoadState(StateReader& reader)
+        {
+            state_ = reader.ReadU64();
+        }
+
+    private:
+        static constexpr uint64_t kMultiplier = 6364136223846793005ULL;
+        static constexpr uint64_t kIncrement = 1442695040888963407ULL;
+
+        uint64_t state_ = 0;
+    };
+}
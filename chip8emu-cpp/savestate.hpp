@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace chip8_emu
+{
+    //
+    // Savestates start with these bytes, followed by kSavestateVersion.
+    //
+    constexpr uint8_t kSavestateMagic[4] = { 'C', '8', 'S', 'T' };
+
+    //
+    // Bump whenever the layout of a savestate changes.
+    // Savestates of any other version are rejected.
+    //
+    constexpr uint16_t kSavestateVersion = 3;
+
+    //
+    // Appends machine state to a byte buffer.
+    // Multi-byte values are stored little endian regardless of the host.
+    //
+    class StateWriter
+    {
+    public:
+        explicit StateWriter(std::vector<uint8_t>& bytes)
+            : bytes_{ bytes }
+        {
+        }
+
+        StateWriter(const StateWriter&) = delete;
+        StateWriter(StateWriter&&) = delete;
+
+        StateWriter& operator=(const StateWriter&) = delete;
+        StateWriter& operator=(StateWriter&&) = delete;
+
+        ~StateWriter() = default;
+
+        void WriteU8(const uint8_t value)
+        {
+            bytes_.push_back(value);
+        }
+
+        void WriteU16(const uint16_t value)
+        {
+            WriteLittleEndian(value, sizeof(value));
+        }
+
+        void WriteU32(const uint32_t value)
+        {
+            WriteLittleEndian(value, sizeof(value));
+        }
+
+        void WriteU64(const uint64_t value)
+        {
+            WriteLittleEndian(value, sizeof(value));
+        }
+
+        void WriteBytes(const uint8_t* data, const size_t size)
+        {
+            bytes_.insert(bytes_.end(), data, data + size);
+        }
+
+    private:
+        void WriteLittleEndian(const uint64_t value, const size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                bytes_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        std::vector<uint8_t>& bytes_;
+    };
+
+    //
+    // Reads back what StateWriter wrote. Throws if the buffer runs out.
+    //
+    class StateReader
+    {
+    public:
+        StateReader(const uint8_t* data, const size_t size)
+            : data_{ data }
+            , size_{ size }
+        {
+        }
+
+        StateReader(const StateReader&) = delete;
+        StateReader(StateReader&&) = delete;
+
+        StateReader& operator=(const StateReader&) = delete;
+        StateReader& operator=(StateReader&&) = delete;
+
+        ~StateReader() = default;
+
+        uint8_t ReadU8()
+        {
+            return static_cast<uint8_t>(ReadLittleEndian(sizeof(uint8_t)));
+        }
+
+        uint16_t ReadU16()
+        {
+            return static_cast<uint16_t>(ReadLittleEndian(sizeof(uint16_t)));
+        }
+
+        uint32_t ReadU32()
+        {
+            return static_cast<uint32_t>(ReadLittleEndian(sizeof(uint32_t)));
+        }
+
+        uint64_t ReadU64()
+        {
+            return ReadLittleEndian(sizeof(uint64_t));
+        }
+
+        void ReadBytes(uint8_t* data, const size_t size)
+        {
+            Require(size);
+            std::memcpy(data, data_ + offset_, size);
+            offset_ += size;
+        }
+
+        size_t GetRemaining() const
+        {
+            return size_ - offset_;
+        }
+
+    private:
+        void Require(const size_t size) const
+        {
+            if (size > GetRemaining())
+            {
+                throw std::runtime_error{ std::format("Savestate is truncated, needed {} more bytes at offset {}", size, offset_) };
+            }
+        }
+
+        uint64_t ReadLittleEndian(const size_t size)
+        {
+            Require(size);
+
+            uint64_t value = 0;
+            for (size_t i = 0; i < size; i++)
+            {
+                value |= static_cast<uint64_t>(data_[offset_ + i]) << (i * 8);
+            }
+            offset_ += size;
+
+            return value;
+        }
+
+        const uint8_t* data_;
+        size_t size_;
+        size_t offset_ = 0;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace chip8_emu
+{
+    //
+    // Paces emulated frames against the wall clock.
+    // Deadlines are computed from the frame count since Reset, so rounding
+    // errors and late wake ups don't accumulate into drift.
+    //
+    class FramePacer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit FramePacer(const uint32_t frames_per_second)
+            : frames_per_second_{ frames_per_second }
+        {
+            Reset();
+        }
+
+        FramePacer(const FramePacer&) = delete;
+        FramePacer(FramePacer&&) = delete;
+
+        FramePacer& operator=(const FramePacer&) = delete;
+        FramePacer& operator=(FramePacer&&) = delete;
+
+        ~FramePacer() = default;
+
+        void Reset()
+        {
+            start_ = Clock::now();
+            frame_ = 0;
+        }
+
+        //
+        // Block until the current frame's deadline.
+        //
+        void WaitForNextFrame()
+        {
+            WaitForNextFrame([](const Clock::time_point deadline)
+            {
+                SleepUntil(deadline);
+                return true;
+            });
+        }
+
+        //
+        // Same, but wait_until(deadline) does the waiting, e.g. to handle window events
+        // meanwhile. Returns false if wait_until did.
+        //
+        template <typename WaitFunction>
+        bool WaitForNextFrame(WaitFunction&& wait_until)
+        {
+            frame_++;
+            const auto deadline = Deadline(frame_);
+
+            //
+            // If we fell more than a few frames behind (debugger, suspended process)
+            // start counting again from now rather than running flat out to catch up.
+            //
+            if (Clock::now() > deadline + kMaxLag)
+            {
+                Reset();
+                return true;
+            }
+
+            return wait_until(deadline);
+        }
+
+        //
+        // OS sleeps overshoot by up to a scheduler quantum. Sleep until shortly before
+        // the deadline and yield for the rest.
+        //
+        static void SleepUntil(const Clock::time_point deadline)
+        {
+            if (deadline - Clock::now() > kSpinWindow)
+            {
+                std::this_thread::sleep_until(deadline - kSpinWindow);
+            }
+
+            while (Clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+    private:
+        static constexpr auto kSpinWindow = std::chrono::milliseconds(2);
+        static constexpr auto kMaxLag = std::chrono::milliseconds(100);
+
+        Clock::time_point Deadline(const uint64_t frame) const
+        {
+            const auto elapsed = std::chrono::nanoseconds(frame * 1'000'000'000ULL / frames_per_second_);
+            return start_ + std::chrono::duration_cast<Clock::duration>(elapsed);
+        }
+
+        uint32_t frames_per_second_;
+        Clock::time_point start_;
+        uint64_t frame_ = 0;
+    };
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <chrono>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "SDL.h"
+#undef main
+
+#include "constants.hpp"
+#include "display_backend.hpp"
+#include "pixels.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Shows frames in an SDL window. Each frame is expanded to ARGB pixels in a
+    // 64x32 streaming texture, and the renderer scales it to the window.
+    // SDL picks the renderer, set SDL_RENDER_DRIVER=software to run without a GPU.
+    // The window lives on the thread that creates the backend, which must also
+    // be the one calling WaitUntil, since that's where SDL events get pumped.
+    //
+    class SdlDisplayBackend : public DisplayBackend
+    {
+    public:
+        SdlDisplayBackend()
+        {
+            if (SDL_Init(SDL_INIT_VIDEO) < 0)
+            {
+                throw std::runtime_error{ std::format("SDL could not be initialized: {}", SDL_GetError()) };
+            }
+
+            //
+            // Create an application window
+            //
+            window_ = SDL_CreateWindow(
+                "CHIP-8 Emu",
+                SDL_WINDOWPOS_UNDEFINED,
+                SDL_WINDOWPOS_UNDEFINED,
+                kHorizontalWindowSize,
+                kVerticalWindowSize,
+                SDL_WINDOW_SHOWN
+            );
+
+            if (window_ == nullptr)
+            {
+                Destroy();
+                throw std::runtime_error("SDL window could not be created");
+            }
+
+            //
+            // Fall back to the software renderer if there's no accelerated one.
+            //
+            renderer_ = SDL_CreateRenderer(window_, -1, 0);
+            if (renderer_ == nullptr)
+            {
+                renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_SOFTWARE);
+            }
+
+            if (renderer_ != nullptr)
+            {
+                texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, kHorizontalDisplaySize, kVerticalDisplaySize);
+            }
+
+            if (texture_ == nullptr)
+            {
+                const std::string error = SDL_GetError();
+                Destroy();
+                throw std::runtime_error{ std::format("SDL renderer could not be created: {}", error) };
+            }
+        }
+
+        SdlDisplayBackend(const SdlDisplayBackend&) = delete;
+        SdlDisplayBackend(SdlDisplayBackend&&) = delete;
+
+        SdlDisplayBackend& operator=(const SdlDisplayBackend&) = delete;
+        SdlDisplayBackend& operator=(SdlDisplayBackend&&) = delete;
+
+        ~SdlDisplayBackend() override
+        {
+            Destroy();
+        }
+
+        void Present(const Framebuffer& frame) override
+        {
+            void* pixels = nullptr;
+            int pitch = 0;
+            if (SDL_LockTexture(texture_, nullptr, &pixels, &pitch) != 0)
+            {
+                throw std::runtime_error{ std::format("Could not lock the screen texture: {}", SDL_GetError()) };
+            }
+
+            ExpandFramebuffer(frame, pixels, static_cast<size_t>(pitch), kOnColor, kOffColor);
+            SDL_UnlockTexture(texture_);
+
+            Render();
+        }
+
+        //
+        // Sleep in SDL_WaitEventTimeout until the deadline, waking up only to
+        // handle events. Key events reach Keyboard through its event watch.
+        //
+        bool WaitUntil(const std::chrono::steady_clock::time_point deadline) override
+        {
+            SDL_Event event;
+            while (true)
+            {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (remaining.count() <= 0)
+                {
+                    //
+                    // SDL only waits in whole milliseconds, leave the rest to the OS.
+                    //
+                    std::this_thread::sleep_until(deadline);
+                    return true;
+                }
+
+                if (SDL_WaitEventTimeout(&event, static_cast<int>(remaining.count())))
+                {
+                    do
+                    {
+                        if (event.type == SDL_QUIT)
+                        {
+                            return false;
+                        }
+
+                        //
+                        // The texture still holds the last frame, show it again.
+                        //
+                        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED)
+                        {
+                            Render();
+                        }
+                    } while (SDL_PollEvent(&event));
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t kOnColor = 0xFFFFFFFF;
+        static constexpr uint32_t kOffColor = 0xFF000000;
+
+        void Render()
+        {
+            SDL_RenderCopy(renderer_, texture_, nullptr, nullptr);
+            SDL_RenderPresent(renderer_);
+        }
+
+        void Destroy()
+        {
+            if (texture_ != nullptr)
+            {
+                SDL_DestroyTexture(texture_);
+            }
+
+            if (renderer_ != nullptr)
+            {
+                SDL_DestroyRenderer(renderer_);
+            }
+
+            if (window_ != nullptr)
+            {
+                SDL_DestroyWindow(window_);
+            }
+
+            SDL_Quit();
+        }
+
+        SDL_Window* window_ = nullptr;
+        SDL_Renderer* renderer_ = nullptr;
+
+        //
+        // 64x32 ARGB copy of the last presented frame
+        //
+        SDL_Texture* texture_ = nullptr;
+    };
+}
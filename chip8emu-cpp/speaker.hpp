@@ -10,8 +10,14 @@ namespace chip8_emu
     class Speaker
     {
     public:
-        Speaker()
+        explicit Speaker(const bool is_headless = false)
+            : is_headless_{ is_headless }
         {
+            if (is_headless_)
+            {
+                return;
+            }
+
             if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
                 std::cerr << "SDL_INIT_AUDIO failed: " << SDL_GetError() << std::endl;
                 return;
@@ -44,6 +50,11 @@ namespace chip8_emu
 
         ~Speaker()
         {
+            if (is_headless_)
+            {
+                return;
+            }
+
             if (device_ != 0)
             {
                 SDL_CloseAudioDevice(device_);
@@ -82,6 +93,7 @@ namespace chip8_emu
             }
         }
 
+        bool is_headless_;
         SDL_AudioDeviceID device_ = 0;
         std::atomic<bool> is_playing_ = false;
         int sample_index_ = 0;
@@ -4,6 +4,7 @@
 #include <stdexcept>
 
 #include "constants.hpp"
+#include "savestate.hpp"
 
 namespace chip8_emu
 {
@@ -40,6 +41,30 @@ namespace chip8_emu
             return data_[sp_];
         }
 
+        void SaveState(StateWriter& writer) const
+        {
+            writer.WriteU8(sp_);
+            for (const auto value : data_)
+            {
+                writer.WriteU16(value);
+            }
+        }
+
+        void LoadState(StateReader& reader)
+        {
+            const auto sp = reader.ReadU8();
+            if (sp > kStackSize)
+            {
+                throw std::runtime_error{ "Savestate has an invalid stack pointer" };
+            }
+
+            sp_ = sp;
+            for (auto& value : data_)
+            {
+                value = reader.ReadU16();
+            }
+        }
+
         ~Stack() = default;
 
     private:
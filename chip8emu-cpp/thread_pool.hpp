@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chip8_emu
+{
+    //
+    // Fixed set of worker threads, each with its own task deque.
+    // Workers take tasks from the back of their own deque and steal from
+    // the front of the others' once it runs dry, so uneven tasks still
+    // keep every core busy without a shared queue everyone contends on.
+    //
+    class WorkStealingPool
+    {
+    public:
+        explicit WorkStealingPool(size_t thread_count = std::thread::hardware_concurrency())
+        {
+            thread_count = std::max<size_t>(thread_count, 1);
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                workers_.push_back(std::make_unique<Worker>());
+            }
+
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                threads_.emplace_back([this, i]() { WorkerLoop(i); });
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool(WorkStealingPool&&) = delete;
+
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard lock{ mutex_ };
+                is_stopping_ = true;
+            }
+            wake_.notify_all();
+
+            for (auto& thread : threads_)
+            {
+                thread.join();
+            }
+        }
+
+        size_t GetThreadCount() const
+        {
+            return threads_.size();
+        }
+
+        //
+        // Call task(i) for every i in [0, count) and wait until all calls have returned.
+        // Tasks must not throw. Only one thread may call ParallelFor at a time.
+        //
+        void ParallelFor(const size_t count, const std::function<void(size_t)>& task)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            //
+            // Hand every worker a contiguous range to start with, stealing evens it out.
+            // The ranges are published together with the task, under the same lock,
+            // so a worker never sees the indices of one batch with the task of another.
+            //
+            {
+                std::lock_guard lock{ mutex_ };
+                const auto worker_count = workers_.size();
+                for (size_t i = 0; i < worker_count; i++)
+                {
+                    std::lock_guard worker_lock{ workers_[i]->mutex };
+                    for (auto index = count * i / worker_count; index < count * (i + 1) / worker_count; index++)
+                    {
+                        workers_[i]->tasks.push_back(index);
+                    }
+                }
+
+                task_ = &task;
+                remaining_ = count;
+                generation_++;
+            }
+            wake_.notify_all();
+
+            //
+            // Also wait for every worker to leave its task loop. The next batch
+            // can only be published once nobody is still running this one.
+            //
+            std::unique_lock lock{ mutex_ };
+            done_.wait(lock, [this]() { return remaining_ == 0 && busy_workers_ == 0; });
+        }
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        void WorkerLoop(const size_t id)
+        {
+            uint64_t generation = 0;
+            while (true)
+            {
+                const std::function<void(size_t)>* task = nullptr;
+                {
+                    std::unique_lock lock{ mutex_ };
+                    wake_.wait(lock, [&]() { return is_stopping_ || generation_ != generation; });
+                    if (is_stopping_)
+                    {
+                        return;
+                    }
+
+                    //
+                    // Woken too late for a batch that's already finished, task_ may
+                    // already be gone. Wait for the next one instead.
+                    //
+                    generation = generation_;
+                    if (remaining_ == 0)
+                    {
+                        continue;
+                    }
+
+                    task = task_;
+                    busy_workers_++;
+                }
+
+                size_t executed = 0;
+                size_t index = 0;
+                while (Pop(id, index) || Steal(id, index))
+                {
+                    (*task)(index);
+                    executed++;
+                }
+
+                {
+                    std::lock_guard lock{ mutex_ };
+                    remaining_ -= executed;
+                    busy_workers_--;
+                }
+                done_.notify_all();
+            }
+        }
+
+        bool Pop(const size_t id, size_t& index)
+        {
+            auto& worker = *workers_[id];
+            std::lock_guard lock{ worker.mutex };
+            if (worker.tasks.empty())
+            {
+                return false;
+            }
+
+            index = worker.tasks.back();
+            worker.tasks.pop_back();
+            return true;
+        }
+
+        bool Steal(const size_t thief, size_t& index)
+        {
+            for (size_t i = 1; i < workers_.size(); i++)
+            {
+                auto& victim = *workers_[(thief + i) % workers_.size()];
+                std::lock_guard lock{ victim.mutex };
+                if (!victim.tasks.empty())
+                {
+                    index = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        //
+        // Guards everything below.
+        //
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        const std::function<void(size_t)>* task_ = nullptr;
+        uint64_t generation_ = 0;
+        size_t remaining_ = 0;
+        size_t busy_workers_ = 0;
+        bool is_stopping_ = false;
+    };
+}
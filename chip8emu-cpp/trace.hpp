@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "constants.hpp"
+
+namespace chip8_emu
+{
+    //
+    // Trace policies for Cpu. Each one is handed the pc and opcode of every
+    // instruction before it executes.
+    //
+
+    //
+    // Production policy, the call compiles to nothing.
+    //
+    struct NoTrace
+    {
+        void Record(const uint16_t, const Opcode)
+        {
+        }
+    };
+
+    //
+    // Human readable trace, one "pc opcode" line per instruction.
+    // Never flushes on its own, the stream decides when to.
+    //
+    class TextTrace
+    {
+    public:
+        explicit TextTrace(std::ostream& out = std::cout)
+            : out_{ &out }
+        {
+        }
+
+        void Record(const uint16_t pc, const Opcode opcode)
+        {
+            *out_ << std::format("{:#06x} {}\n", pc, opcode.ToString());
+        }
+
+    private:
+        std::ostream* out_;
+    };
+
+    //
+    // Record written by BinaryTrace, in host byte order.
+    //
+    struct TraceRecord
+    {
+        uint16_t pc;
+        uint16_t opcode;
+    };
+
+    //
+    // Compact trace for long runs. Records go into a single producer, single consumer
+    // lock-free ring buffer and a background thread drains them to a file.
+    // If the writer falls behind the CPU waits for room rather than dropping records.
+    //
+    class BinaryTrace
+    {
+    public:
+        explicit BinaryTrace(const std::string& path)
+            : file_{ path, std::ios::binary | std::ios::trunc }
+        {
+            if (!file_)
+            {
+                throw std::runtime_error{ std::format("Could not open trace file {}", path) };
+            }
+
+            writer_thread_ = std::thread([this]() { Drain(); });
+        }
+
+        BinaryTrace(const BinaryTrace&) = delete;
+        BinaryTrace(BinaryTrace&&) = delete;
+
+        BinaryTrace& operator=(const BinaryTrace&) = delete;
+        BinaryTrace& operator=(BinaryTrace&&) = delete;
+
+        ~BinaryTrace()
+        {
+            is_stopping_ = true;
+            writer_thread_.join();
+        }
+
+        void Record(const uint16_t pc, const Opcode opcode)
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+            while (head - tail_.load(std::memory_order_acquire) == kCapacity)
+            {
+                std::this_thread::yield();
+            }
+
+            records_[head & kMask] = TraceRecord{ pc, opcode.Value() };
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+    private:
+        static constexpr uint64_t kCapacity = 1 << 16;
+        static constexpr uint64_t kMask = kCapacity - 1;
+
+        void Drain()
+        {
+            while (true)
+            {
+                //
+                // Check for stopping before looking at head, so every record
+                // produced before the destructor ran is written out.
+                //
+                const bool is_stopping = is_stopping_;
+                const auto head = head_.load(std::memory_order_acquire);
+                auto tail = tail_.load(std::memory_order_relaxed);
+
+                if (head == tail)
+                {
+                    if (is_stopping)
+                    {
+                        break;
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+
+                while (tail != head)
+                {
+                    const auto start = tail & kMask;
+                    const auto count = std::min(head - tail, kCapacity - start);
+                    file_.write(reinterpret_cast<const char*>(&records_[start]), count * sizeof(TraceRecord));
+
+                    tail += count;
+                    tail_.store(tail, std::memory_order_release);
+                }
+            }
+
+            file_.flush();
+        }
+
+        std::array<TraceRecord, kCapacity> records_{};
+
+        //
+        // Written by the CPU thread and the writer thread respectively.
+        // Kept on separate cache lines so they don't bounce between cores.
+        //
+        alignas(64) std::atomic<uint64_t> head_ = 0;
+        alignas(64) std::atomic<uint64_t> tail_ = 0;
+
+        std::atomic_bool is_stopping_ = false;
+        std::ofstream file_;
+        std::thread writer_thread_;
+    };
+}
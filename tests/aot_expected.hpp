@@ -0,0 +1,127 @@
+// Generated by chip8-aot from kPatchingRom in test_aot.cpp, do not edit.
+
+#include "aot_main.hpp"
+
+namespace
+{
+using Aot = chip8_emu::Aot<chip8_emu::Cpu<>>;
+
+const uint8_t kRom[] =
+{
+    0x22, 0x1c, 0x63, 0x02, 0xf3, 0x15, 0xf3, 0x07, 0x33, 0x00, 0x12, 0x06, 0xb2, 0x10, 0x00, 0x00,
+    0xa2, 0x1c, 0x60, 0x74, 0x61, 0x05, 0xf1, 0x55, 0x22, 0x1c, 0x12, 0x1a, 0x74, 0x01, 0xa3, 0x00,
+    0xf4, 0x33, 0x00, 0xee,
+};
+
+const chip8_emu::CompiledBlock kBlocks[] =
+{
+    { 0x200, 0x202 },
+    { 0x202, 0x206 },
+    { 0x206, 0x20a },
+    { 0x20a, 0x20c },
+    { 0x20c, 0x20e },
+    { 0x21c, 0x224 },
+};
+
+uint64_t Run(Aot& aot, const uint64_t budget)
+{
+    uint64_t executed = 0;
+
+dispatch:
+    switch (aot.GetPc())
+    {
+    case 0x200: goto L_200;
+    case 0x202: goto L_202;
+    case 0x206: goto L_206;
+    case 0x20a: goto L_20a;
+    case 0x20c: goto L_20c;
+    case 0x21c: goto L_21c;
+    default: return executed;
+    }
+
+L_200:
+    if (budget - executed < 1)
+    {
+        aot.SetPc(0x200);
+        return executed;
+    }
+    executed += 1;
+    aot.SetPc(0x202);
+    aot.Step<0x221C>(); // 0x200: CALL 0x21c
+    goto L_21c;
+
+L_202:
+    if (budget - executed < 2)
+    {
+        aot.SetPc(0x202);
+        return executed;
+    }
+    executed += 2;
+    aot.Step<0x6302>(); // 0x202: LD V3, 0x02
+    aot.Step<0xF315>(); // 0x204: LD DT, V3
+    goto L_206;
+
+L_206:
+    if (budget - executed < 2)
+    {
+        aot.SetPc(0x206);
+        return executed;
+    }
+    executed += 2;
+    aot.Step<0xF307>(); // 0x206: LD V3, DT
+    aot.SetPc(0x20a);
+    aot.Step<0x3300>(); // 0x208: SE V3, 0x00
+    if (aot.GetPc() == 0x20a)
+    {
+        goto L_20a;
+    }
+    goto L_20c;
+
+L_20a:
+    if (budget - executed < 1)
+    {
+        aot.SetPc(0x20a);
+        return executed;
+    }
+    executed += 1;
+    aot.SetPc(0x20c);
+    aot.Step<0x1206>(); // 0x20a: JP 0x206
+    if (aot.MustExit())
+    {
+        return executed;
+    }
+    goto L_206;
+
+L_20c:
+    if (budget - executed < 1)
+    {
+        aot.SetPc(0x20c);
+        return executed;
+    }
+    executed += 1;
+    aot.SetPc(0x20e);
+    aot.Step<0xB210>(); // 0x20c: JP V0, 0x210
+    goto dispatch;
+
+L_21c:
+    if (budget - executed < 4)
+    {
+        aot.SetPc(0x21c);
+        return executed;
+    }
+    executed += 4;
+    aot.Step<0x7401>(); // 0x21c: ADD V4, 0x01
+    aot.Step<0xA300>(); // 0x21e: LD I, 0x300
+    aot.Step<0xF433>(); // 0x220: LD B, V4
+    if (aot.MustExit())
+    {
+        aot.SetPc(0x222);
+        return executed - 1;
+    }
+    aot.SetPc(0x224);
+    aot.Step<0x00EE>(); // 0x222: RET
+    goto dispatch;
+}
+
+const chip8_emu::CompiledProgram<chip8_emu::Cpu<>> kProgram{ kRom, kBlocks, &Run };
+}
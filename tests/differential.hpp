@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "farm.hpp"
+
+//
+// Shared by the differential tests: random programs, and running them on a
+// headless Cpu to compare another core or engine against.
+//
+
+//
+// Which instructions random_rom draws from. kCore covers everything that
+// doesn't need input, random numbers or the display. kFull adds those, and
+// computed jumps.
+//
+enum class OpcodeMix {
+    kCore,
+    kFull,
+};
+
+inline std::vector<uint8_t> random_rom(std::mt19937& rng, const size_t instructions, const OpcodeMix mix) {
+    const bool is_full = mix == OpcodeMix::kFull;
+
+    std::vector<uint8_t> rom;
+    auto nibble = [&]() { return static_cast<uint16_t>(rng() & 0xF); };
+    auto byte = [&]() { return static_cast<uint16_t>(rng() & 0xFF); };
+    auto target = [&]() { return static_cast<uint16_t>(0x200 + 2 * (rng() % instructions)); };
+
+    static const uint16_t kAlu[] = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+    static const uint16_t kMisc[] = { 0x07, 0x15, 0x18, 0x1E, 0x29, 0x33, 0x55, 0x65, 0x0A };
+    const size_t misc_count = std::size(kMisc) - (is_full ? 0 : 1);
+
+    for (size_t i = 0; i < instructions; i++) {
+        //
+        // kCore only picks from cases 0 to 10 and the default.
+        //
+        auto pick = rng() % (is_full ? 16 : 12);
+        if (!is_full && pick == 11) {
+            pick = 15;
+        }
+
+        uint16_t opcode = 0;
+        switch (pick) {
+        case 0: opcode = 0x6000 | (nibble() << 8) | byte(); break;
+        case 1: opcode = 0x7000 | (nibble() << 8) | byte(); break;
+        case 2:
+        case 3: opcode = 0x8000 | (nibble() << 8) | (nibble() << 4) | kAlu[rng() % std::size(kAlu)]; break;
+        case 4: opcode = 0x3000 | (nibble() << 8) | byte(); break;
+        case 5: opcode = 0x4000 | (nibble() << 8) | byte(); break;
+        case 6: opcode = ((rng() & 1) ? 0x5000 : 0x9000) | (nibble() << 8) | (nibble() << 4); break;
+        case 7: opcode = 0xA000 | (0x200 + (rng() % 0x300)); break;
+        case 8:
+        case 9: opcode = 0xF000 | (nibble() << 8) | kMisc[rng() % misc_count]; break;
+        case 10: opcode = 0x1000 | target(); break;
+        case 11: opcode = 0xC000 | (nibble() << 8) | byte(); break;
+        case 12: opcode = 0xD000 | (nibble() << 8) | (nibble() << 4) | nibble(); break;
+        case 13: opcode = ((rng() & 1) ? 0xE09E : 0xE0A1) | (nibble() << 8); break;
+        case 14: opcode = (rng() % 8 == 0) ? 0x00E0 : (0xB000 | (target() - (rng() % 4))); break;
+        default: opcode = (rng() & 1) ? (0x2000 | target()) : 0x00EE; break;
+        }
+        rom.push_back(static_cast<uint8_t>(opcode >> 8));
+        rom.push_back(static_cast<uint8_t>(opcode));
+    }
+    return rom;
+}
+
+struct Outcome {
+    chip8_emu::FarmResult result;
+    chip8_emu::Registers registers{};
+};
+
+//
+// The reference run: frames frames on a headless Cpu, stopping like a Farm instance does.
+//
+inline Outcome run_cpu(const chip8_emu::CpuCore core, const std::vector<uint8_t>& rom, const uint32_t seed, const uint64_t frames, const uint32_t instructions_per_frame) {
+    using chip8_emu::ExitReason;
+
+    chip8_emu::Cpu<> cpu(core, chip8_emu::Frontend::kHeadless);
+    cpu.Seed(seed);
+    cpu.Load(rom);
+
+    Outcome outcome;
+    try {
+        for (uint64_t frame = 0; frame < frames && !cpu.IsTrapped() && !cpu.IsParked() && !cpu.GetMemory().HasFault(); frame++) {
+            outcome.result.instructions += cpu.RunFrame(instructions_per_frame);
+            outcome.result.frames++;
+        }
+    } catch (const std::exception& e) {
+        outcome.result.exit_reason = ExitReason::kError;
+        outcome.result.error = e.what();
+    }
+    if (cpu.GetMemory().HasFault()) {
+        outcome.result.exit_reason = ExitReason::kError;
+        outcome.result.error = "Memory fault: " + cpu.GetMemory().GetFault().ToString();
+    } else if (cpu.IsTrapped()) {
+        outcome.result.exit_reason = ExitReason::kTrapped;
+    } else if (cpu.IsParked()) {
+        outcome.result.exit_reason = ExitReason::kWaitingForKey;
+    }
+    outcome.result.framebuffer_hash = cpu.GetFramebuffer().Hash();
+    outcome.registers = cpu.GetRegisters();
+    return outcome;
+}
+
+//
+// Counts only have to match when nothing threw, an exception can leave them anywhere.
+//
+inline void expect_same(const Outcome& actual, const Outcome& expected) {
+    assert(actual.result.exit_reason == expected.result.exit_reason);
+    assert(actual.result.error == expected.result.error);
+    assert(actual.result.framebuffer_hash == expected.result.framebuffer_hash);
+    assert(std::memcmp(&actual.registers, &expected.registers, sizeof(expected.registers)) == 0);
+    if (expected.result.exit_reason != chip8_emu::ExitReason::kError) {
+        assert(actual.result.instructions == expected.result.instructions);
+        assert(actual.result.frames == expected.result.frames);
+    }
+}
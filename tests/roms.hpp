@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//
+// Test programs shared by more than one test.
+//
+
+//
+// Endless loop touching the stack, memory, timers, the screen and the RNG.
+//
+inline const std::vector<uint8_t> kBusyRom = {
+    0xC0, 0x3F, // 0x200: V0 = rand & 0x3F
+    0xC1, 0x1F, // 0x202: V1 = rand & 0x1F
+    0x22, 0x10, // 0x204: call 0x210
+    0xF0, 0x15, // 0x206: delay timer = V0
+    0x12, 0x00, // 0x208: jump 0x200
+    0x00, 0x00, // 0x20A
+    0x00, 0x00, // 0x20C
+    0x00, 0x00, // 0x20E
+    0xA3, 0x00, // 0x210: I = 0x300
+    0xF0, 0x33, // 0x212: BCD of V0 at I
+    0xF2, 0x65, // 0x214: V0-V2 = memory at I
+    0xF2, 0x29, // 0x216: I = sprite for V2
+    0xD0, 0x15, // 0x218: draw at V0, V1
+    0x00, 0xEE, // 0x21A: return
+};
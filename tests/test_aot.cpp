@@ -0,0 +1,159 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "aot_emitter.hpp"
+#include "cfg.hpp"
+#include "cpu.hpp"
+
+//
+// What AotEmitter writes for kPatchingRom, checked in so the test can build and
+// run it. Defines kRom, kBlocks, Run and kProgram.
+//
+#include "aot_expected.hpp"
+
+using chip8_emu::AotEmitter;
+using chip8_emu::CompiledProgram;
+using chip8_emu::ControlFlowGraph;
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+//
+// Calls a subroutine, waits for the delay timer, then takes a computed jump into
+// code the control flow graph can't see, which patches the subroutine and calls it again.
+//
+static const std::vector<uint8_t> kPatchingRom = {
+    0x22, 0x1C, // 0x200: call 0x21C
+    0x63, 0x02, // 0x202: V3 = 2
+    0xF3, 0x15, // 0x204: delay timer = V3
+    0xF3, 0x07, // 0x206: V3 = delay timer
+    0x33, 0x00, // 0x208: skip if V3 == 0
+    0x12, 0x06, // 0x20A: jump 0x206
+    0xB2, 0x10, // 0x20C: jump 0x210 + V0
+    0x00, 0x00,
+    0xA2, 0x1C, // 0x210: I = 0x21C
+    0x60, 0x74, // 0x212: V0 = 0x74
+    0x61, 0x05, // 0x214: V1 = 0x05
+    0xF1, 0x55, // 0x216: store V0-V1, turns 0x21C into V4 += 5
+    0x22, 0x1C, // 0x218: call 0x21C
+    0x12, 0x1A, // 0x21A: jump 0x21A
+    0x74, 0x01, // 0x21C: V4 += 1
+    0xA3, 0x00, // 0x21E: I = 0x300
+    0xF4, 0x33, // 0x220: BCD of V4 at I
+    0x00, 0xEE, // 0x222: return
+};
+
+static uint64_t compiled_instructions = 0;
+
+//
+// The generated code, counting what it runs.
+//
+static uint64_t counting_run(Aot& aot, const uint64_t budget) {
+    const auto executed = Run(aot, budget);
+    compiled_instructions += executed;
+    return executed;
+}
+
+const CompiledProgram<Cpu<>> kCountingProgram{ kRom, kBlocks, &counting_run };
+
+void test_emitter_output_is_unchanged() {
+    std::ostringstream emitted;
+    AotEmitter::EmitProgram(ControlFlowGraph(kPatchingRom), "kPatchingRom in test_aot.cpp", emitted);
+
+    const auto path = std::filesystem::path(__FILE__).parent_path() / "aot_expected.hpp";
+    std::ifstream io(path, std::ios::binary);
+    if (!io) {
+        throw std::runtime_error{ "Could not open " + path.string() };
+    }
+    std::ostringstream expected;
+    expected << io.rdbuf();
+
+    //
+    // After changing AotEmitter on purpose, check the .actual file and copy it over.
+    //
+    if (emitted.str() != expected.str()) {
+        std::ofstream(path.string() + ".actual", std::ios::binary) << emitted.str();
+    }
+    assert(emitted.str() == expected.str());
+    assert(std::vector<uint8_t>(std::begin(kRom), std::end(kRom)) == kPatchingRom);
+    std::cout << "test_emitter_output_is_unchanged passed\n";
+}
+
+void test_compiled_program_matches_interpreter() {
+    for (uint32_t instructions_per_frame = 1; instructions_per_frame <= 20; instructions_per_frame++) {
+        Cpu<> interpreted(CpuCore::kHandlerTable, Frontend::kHeadless);
+        interpreted.Load(kPatchingRom);
+
+        Cpu<> compiled(CpuCore::kHandlerTable, Frontend::kHeadless);
+        compiled.Load(kPatchingRom);
+        compiled.UseCompiledProgram(kProgram);
+
+        //
+        // Budgets split blocks anywhere, compiled code must stop and resume exactly.
+        //
+        for (int frame = 0; frame < 30; frame++) {
+            assert(compiled.RunFrame(instructions_per_frame) == interpreted.RunFrame(instructions_per_frame));
+            assert(std::memcmp(&compiled.GetRegisters(), &interpreted.GetRegisters(), sizeof(chip8_emu::Registers)) == 0);
+        }
+        assert(compiled.GetRegisters().v[4] == 6);
+        assert(compiled.GetRegisters().pc == 0x21A);
+    }
+    std::cout << "test_compiled_program_matches_interpreter passed\n";
+}
+
+void test_uncompiled_and_modified_code_is_interpreted() {
+    compiled_instructions = 0;
+
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(kPatchingRom);
+    cpu.UseCompiledProgram(kCountingProgram);
+
+    //
+    // The call, the subroutine and one round of the delay timer loop run compiled.
+    // The rest of the frame is skipped as an idle loop.
+    //
+    assert(cpu.RunFrame(100) == 100);
+    const auto first_frame = compiled_instructions;
+    assert(first_frame == 10);
+
+    //
+    // The computed jump target isn't compiled, and the patched subroutine
+    // must not run from its compiled copy.
+    //
+    for (int frame = 0; frame < 10; frame++) {
+        cpu.RunFrame(100);
+    }
+    assert(cpu.GetRegisters().v[4] == 6);
+    assert(cpu.GetRegisters().pc == 0x21A);
+
+    const auto finished = compiled_instructions;
+    cpu.RunFrame(100);
+    assert(compiled_instructions == finished);
+
+    //
+    // Loading the ROM again restores the compiled code.
+    //
+    cpu.Load(kPatchingRom);
+    cpu.RunFrame(100);
+    assert(compiled_instructions == finished + first_frame);
+    std::cout << "test_uncompiled_and_modified_code_is_interpreted passed\n";
+}
+
+int main() {
+    try {
+        test_emitter_output_is_unchanged();
+        test_compiled_program_matches_interpreter();
+        test_uncompiled_and_modified_code_is_interpreted();
+        std::cout << "All AOT tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
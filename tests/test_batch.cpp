@@ -0,0 +1,110 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "batch.hpp"
+#include "differential.hpp"
+
+//
+// Differential tests: every lane must end in exactly the same state as a headless Cpu.
+//
+
+using chip8_emu::Batch;
+using chip8_emu::CpuCore;
+
+template <size_t kLanes>
+static void expect_same(const std::vector<uint8_t>& rom, const std::vector<uint32_t>& seeds, const uint64_t frames, const uint32_t instructions_per_frame) {
+    Batch<kLanes> batch(rom, seeds);
+    const auto results = batch.Run(frames, instructions_per_frame);
+
+    for (size_t lane = 0; lane < seeds.size(); lane++) {
+        const Outcome actual{ results[lane], batch.GetRegisters(lane) };
+        expect_same(actual, run_cpu(CpuCore::kHandlerTable, rom, seeds[lane], frames, instructions_per_frame));
+    }
+}
+
+void test_batch_lockstep_loop() {
+    //
+    // Random sprites in an endless loop, lanes only differ in their data.
+    //
+    const std::vector<uint8_t> rom = {
+        0xC0, 0x3F, 0xC1, 0x1F, 0xA0, 0x00, 0xD0, 0x15,
+        0x80, 0x14, 0x81, 0x06, 0x72, 0x01, 0x12, 0x00,
+    };
+    std::vector<uint32_t> seeds(32);
+    for (uint32_t i = 0; i < seeds.size(); i++) {
+        seeds[i] = i + 1;
+    }
+
+    Batch<32> batch(rom, seeds);
+    batch.Run(60, 100);
+    assert(batch.GetDivergentSteps() == 0);
+    assert(batch.GetLockstepSteps() == 6000);
+
+    expect_same<32>(rom, seeds, 60, 100);
+    std::cout << "test_batch_lockstep_loop passed\n";
+}
+
+void test_batch_divergent_lanes() {
+    //
+    // Random skips and a computed jump keep splitting the lanes up.
+    //
+    const std::vector<uint8_t> rom = {
+        0xC0, 0x03, // 0x200: V0 = rand & 3
+        0x30, 0x00, // 0x202: skip if V0 == 0
+        0x71, 0x01, // 0x204: V1 += 1
+        0x40, 0x01, // 0x206: skip if V0 != 1
+        0x72, 0x05, // 0x208: V2 += 5
+        0x83, 0x04, // 0x20A: V3 += V0
+        0x80, 0x04, // 0x20C: V0 += V0
+        0xB2, 0x10, // 0x20E: jump 0x210 + V0
+        0x74, 0x01, // 0x210: V4 += 1
+        0x74, 0x02, // 0x212: V4 += 2
+        0x74, 0x03, // 0x214: V4 += 3
+        0x12, 0x00, // 0x216: jump 0x200
+    };
+    std::vector<uint32_t> seeds(32);
+    for (uint32_t i = 0; i < seeds.size(); i++) {
+        seeds[i] = 1000 + i;
+    }
+
+    Batch<32> batch(rom, seeds);
+    batch.Run(60, 50);
+    assert(batch.GetDivergentSteps() > 0);
+
+    expect_same<32>(rom, seeds, 60, 50);
+    std::cout << "test_batch_divergent_lanes passed\n";
+}
+
+void test_batch_random_programs() {
+    std::mt19937 rng(4321);
+    for (int i = 0; i < 300; i++) {
+        const auto rom = random_rom(rng, 8 + rng() % 120, OpcodeMix::kFull);
+        std::vector<uint32_t> seeds(1 + rng() % 16);
+        for (auto& seed : seeds) {
+            seed = rng();
+        }
+        const uint64_t frames = 1 + rng() % 50;
+        const uint32_t instructions_per_frame = 1 + rng() % 30;
+
+        expect_same<16>(rom, seeds, frames, instructions_per_frame);
+        if (seeds.size() <= 8) {
+            expect_same<8>(rom, seeds, frames, instructions_per_frame);
+        }
+    }
+    std::cout << "test_batch_random_programs passed\n";
+}
+
+int main() {
+    try {
+        test_batch_lockstep_loop();
+        test_batch_divergent_lanes();
+        test_batch_random_programs();
+        std::cout << "All Batch tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
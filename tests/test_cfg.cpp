@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+#include "cfg.hpp"
+
+using chip8_emu::BlockExit;
+using chip8_emu::ControlFlowGraph;
+using chip8_emu::Decoder;
+using chip8_emu::Opcode;
+
+static const std::vector<uint8_t> kRom = {
+    0x00, 0xE0, // 0x200: CLS
+    0x22, 0x10, // 0x202: CALL 0x210
+    0x30, 0x00, // 0x204: SE V0, 0
+    0x12, 0x0A, // 0x206: JP 0x20A
+    0x60, 0x01, // 0x208: LD V0, 1
+    0xA2, 0x20, // 0x20A: LD I, 0x220
+    0xD0, 0x15, // 0x20C: DRW V0, V1, 5
+    0x12, 0x00, // 0x20E: JP 0x200
+    0x70, 0x01, // 0x210: ADD V0, 1
+    0xB2, 0x14, // 0x212: JP V0, 0x214
+    0x00, 0xEE, // 0x214: RET, only reachable through V0
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0x220: sprite
+};
+
+void test_cfg_recovers_blocks() {
+    const ControlFlowGraph cfg(kRom);
+
+    const auto& blocks = cfg.GetBlocks();
+    assert(blocks.size() == 6);
+
+    const auto* entry = cfg.FindBlock(0x200);
+    assert(entry->end == 0x204);
+    assert(entry->exit == BlockExit::kCall && entry->target == 0x210);
+    assert(entry->successors == std::vector<uint16_t>{ 0x204 });
+
+    const auto* skip = cfg.FindBlock(0x204);
+    assert(skip->exit == BlockExit::kSkip);
+    assert((skip->successors == std::vector<uint16_t>{ 0x206, 0x208 }));
+
+    assert(cfg.FindBlock(0x208)->exit == BlockExit::kFallthrough);
+    assert(cfg.FindBlock(0x208)->successors == std::vector<uint16_t>{ 0x20A });
+
+    const auto* loop = cfg.FindBlock(0x20A);
+    assert(loop->end == 0x210);
+    assert(loop->successors == std::vector<uint16_t>{ 0x200 });
+
+    const auto* computed = cfg.FindBlock(0x210);
+    assert(computed->exit == BlockExit::kComputedJump && computed->target == 0x214);
+    assert(computed->successors.empty());
+    assert(cfg.HasComputedJumps());
+    assert(!cfg.IsCode(0x214));
+    std::cout << "test_cfg_recovers_blocks passed\n";
+}
+
+void test_cfg_call_graph_and_data() {
+    const ControlFlowGraph cfg(kRom);
+
+    const auto& functions = cfg.GetFunctions();
+    assert(functions.size() == 2);
+    assert((functions.at(0x200).blocks == std::vector<uint16_t>{ 0x200, 0x204, 0x206, 0x208, 0x20A }));
+    assert(functions.at(0x200).callees == std::vector<uint16_t>{ 0x210 });
+    assert(functions.at(0x210).blocks == std::vector<uint16_t>{ 0x210 });
+    assert(functions.at(0x210).callees.empty());
+
+    const auto& data = cfg.GetDataRegions();
+    assert(data.size() == 1);
+    assert(data[0].start == 0x214 && data[0].end == 0x225);
+    assert(data[0].is_referenced);
+    assert(cfg.GetIndexTargets().contains(0x220));
+    std::cout << "test_cfg_call_graph_and_data passed\n";
+}
+
+//
+// The jump lands on the second byte of LD V0, 0x12, where 0x12 0x0A decodes as
+// JP 0x20A, the only way to reach the return.
+//
+void test_cfg_jump_into_instruction() {
+    static const std::vector<uint8_t> kOverlappingRom = {
+        0x30, 0x00, // 0x200: SE V0, 0
+        0x12, 0x05, // 0x202: JP 0x205
+        0x60, 0x12, // 0x204: LD V0, 0x12
+        0x0A, 0x00, // 0x206: SYS 0xA00
+        0x00, 0x00,
+        0x00, 0xEE, // 0x20A: RET
+    };
+    const ControlFlowGraph cfg(kOverlappingRom);
+
+    assert(cfg.GetBlocks().size() == 5);
+    assert(cfg.FindBlock(0x204)->end == 0x208);
+    assert(cfg.FindBlock(0x204)->exit == BlockExit::kStop);
+
+    const auto* inside = cfg.FindBlock(0x205);
+    assert(inside->end == 0x207);
+    assert(inside->exit == BlockExit::kJump && inside->target == 0x20A);
+    assert(inside->successors == std::vector<uint16_t>{ 0x20A });
+
+    assert(cfg.FindBlock(0x20A)->exit == BlockExit::kReturn);
+    assert(cfg.IsCode(0x20A));
+    assert(cfg.GetDataRegions().size() == 1);
+    assert(cfg.GetDataRegions()[0].start == 0x208 && cfg.GetDataRegions()[0].end == 0x20A);
+    std::cout << "test_cfg_jump_into_instruction passed\n";
+}
+
+void test_disassemble() {
+    Opcode opcode;
+    opcode.first_byte = 0xD1;
+    opcode.second_byte = 0x2F;
+    assert(Decoder::Disassemble(opcode) == "DRW V1, V2, 15");
+    opcode.first_byte = 0xFA;
+    opcode.second_byte = 0x65;
+    assert(Decoder::Disassemble(opcode) == "LD VA, [I]");
+    opcode.first_byte = 0x81;
+    opcode.second_byte = 0x2F;
+    assert(Decoder::Disassemble(opcode) == "DW 0x812f");
+    std::cout << "test_disassemble passed\n";
+}
+
+int main() {
+    try {
+        test_cfg_recovers_blocks();
+        test_cfg_call_graph_and_data();
+        test_cfg_jump_into_instruction();
+        test_disassemble();
+        std::cout << "All CFG tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include "decoder.hpp"
+
+using chip8_emu::Decoder;
+using chip8_emu::Instruction;
+
+void test_decoder_known_opcodes() {
+    assert(Decoder::Decode(0x00E0) == Instruction::kClearScreen);
+    assert(Decoder::Decode(0x00EE) == Instruction::kReturn);
+    assert(Decoder::Decode(0x1234) == Instruction::kJump);
+    assert(Decoder::Decode(0x2ABC) == Instruction::kCall);
+    assert(Decoder::Decode(0x8AB4) == Instruction::kAddVxVy);
+    assert(Decoder::Decode(0x8ABE) == Instruction::kShlVxVy);
+    assert(Decoder::Decode(0xD125) == Instruction::kDraw);
+    assert(Decoder::Decode(0xE39E) == Instruction::kSkipIfPressed);
+    assert(Decoder::Decode(0xF365) == Instruction::kSetRegisters);
+    std::cout << "test_decoder_known_opcodes passed\n";
+}
+
+void test_decoder_invalid_opcodes() {
+    assert(Decoder::Decode(0x0123) == Instruction::kInvalid);
+    assert(Decoder::Decode(0x8AB9) == Instruction::kInvalid);
+    assert(Decoder::Decode(0xE3FF) == Instruction::kInvalid);
+    assert(Decoder::Decode(0xFFFF) == Instruction::kInvalid);
+    std::cout << "test_decoder_invalid_opcodes passed\n";
+}
+
+void test_decoder_is_constexpr() {
+    static_assert(Decoder::Decode(0x6A42) == Instruction::kSetVxRegister);
+    static_assert(Decoder::Decode(0xF000) == Instruction::kInvalid);
+    std::cout << "test_decoder_is_constexpr passed\n";
+}
+
+int main() {
+    try {
+        test_decoder_known_opcodes();
+        test_decoder_invalid_opcodes();
+        test_decoder_is_constexpr();
+        std::cout << "All Decoder tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+#include "pixels.hpp"
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Framebuffer;
+using chip8_emu::Frontend;
+using chip8_emu::HeadlessDisplayBackend;
+
+void test_framebuffer_draw_and_collision() {
+    Framebuffer frame;
+    const uint8_t sprite[] = { 0xF0, 0x90 };
+
+    assert(!frame.Draw(62, 31, sprite, 2));
+    assert(frame.IsPixelOn(62, 31));
+    assert(frame.IsPixelOn(63, 31));
+    assert(!frame.IsPixelOn(0, 31));
+    assert(!frame.IsPixelOn(62, 0));
+
+    assert(frame.Draw(62, 31, sprite, 1));
+    assert(!frame.IsPixelOn(62, 31));
+
+    frame.Clear();
+    assert(!frame.IsPixelOn(63, 31));
+    std::cout << "test_framebuffer_draw_and_collision passed\n";
+}
+
+//
+// Pixel by pixel drawing, as the framebuffer used to do it.
+//
+struct ReferenceFramebuffer {
+    bool pixels[64][32] = {};
+
+    bool Draw(uint16_t x, uint16_t y, const uint8_t* sprite, const uint8_t sprite_size) {
+        bool turned_off = false;
+        x %= 64;
+        y %= 32;
+        for (unsigned i = 0; i < sprite_size && y + i < 32; i++) {
+            for (unsigned bit = 0; bit < 8 && x + bit < 64; bit++) {
+                if (sprite[i] & (0x80 >> bit)) {
+                    auto& pixel = pixels[x + bit][y + i];
+                    turned_off |= pixel;
+                    pixel = !pixel;
+                }
+            }
+        }
+        return turned_off;
+    }
+};
+
+void test_framebuffer_matches_per_pixel_drawing() {
+    std::mt19937 rng(42);
+    Framebuffer frame;
+    ReferenceFramebuffer reference;
+
+    for (int i = 0; i < 5000; i++) {
+        uint8_t sprite[15];
+        for (auto& line : sprite) {
+            line = static_cast<uint8_t>(rng());
+        }
+        const auto x = static_cast<uint16_t>(rng() & 0xFF);
+        const auto y = static_cast<uint16_t>(rng() & 0xFF);
+        const auto size = static_cast<uint8_t>(rng() % 16);
+
+        assert(frame.Draw(x, y, sprite, size) == reference.Draw(x, y, sprite, size));
+    }
+
+    for (uint8_t x = 0; x < 64; x++) {
+        for (uint8_t y = 0; y < 32; y++) {
+            assert(frame.IsPixelOn(x, y) == reference.pixels[x][y]);
+        }
+    }
+    std::cout << "test_framebuffer_matches_per_pixel_drawing passed\n";
+}
+
+void test_framebuffer_expands_to_pixels() {
+    std::mt19937 rng(7);
+    Framebuffer frame;
+    for (int i = 0; i < 200; i++) {
+        const uint8_t sprite[2] = { static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()) };
+        frame.Draw(static_cast<uint16_t>(rng() & 0x3F), static_cast<uint16_t>(rng() & 0x1F), sprite, 2);
+    }
+
+    //
+    // Rows are padded like a texture's can be, the padding must stay untouched.
+    //
+    constexpr size_t kPitch = 64 + 4;
+    constexpr uint32_t kOn = 0xFFFFFFFF;
+    constexpr uint32_t kOff = 0xFF000000;
+    constexpr uint32_t kPadding = 0x12345678;
+    std::vector<uint32_t> pixels(kPitch * 32, kPadding);
+    ExpandFramebuffer(frame, pixels.data(), kPitch * sizeof(uint32_t), kOn, kOff);
+
+    for (uint8_t y = 0; y < 32; y++) {
+        for (uint8_t x = 0; x < 64; x++) {
+            assert(pixels[y * kPitch + x] == (frame.IsPixelOn(x, y) ? kOn : kOff));
+        }
+        for (size_t x = 64; x < kPitch; x++) {
+            assert(pixels[y * kPitch + x] == kPadding);
+        }
+    }
+    std::cout << "test_framebuffer_expands_to_pixels passed\n";
+}
+
+void test_headless_backend_receives_frames() {
+    const std::vector<uint8_t> rom = {
+        0xA0, 0x00, // 0x200: I = sprite for 0
+        0xD0, 0x05, // 0x202: draw at V0, V0
+        0x00, 0xE0, // 0x204: clear screen
+        0xD0, 0x05, // 0x206: draw at V0, V0
+    };
+
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    auto backend = std::make_unique<HeadlessDisplayBackend>();
+    const auto& frames = *backend;
+    cpu.SetDisplayBackend(std::move(backend));
+
+    //
+    // Frames are only presented on request, and only if something was drawn since.
+    //
+    cpu.Load(rom);
+    cpu.Execute(2);
+    assert(frames.GetFramesPresented() == 0);
+    cpu.PresentFrame();
+    cpu.PresentFrame();
+    assert(frames.GetFramesPresented() == 1);
+    cpu.Execute(2);
+    cpu.PresentFrame();
+    assert(frames.GetFramesPresented() == 2);
+    assert(cpu.GetFramebuffer().IsPixelOn(0, 0));
+    assert(cpu.GetRegisters().v[0xF] == 0);
+    std::cout << "test_headless_backend_receives_frames passed\n";
+}
+
+int main() {
+    try {
+        test_framebuffer_draw_and_collision();
+        test_framebuffer_matches_per_pixel_drawing();
+        test_framebuffer_expands_to_pixels();
+        test_headless_backend_receives_frames();
+        std::cout << "All Display tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "farm.hpp"
+
+using chip8_emu::ExitReason;
+using chip8_emu::Farm;
+using chip8_emu::WorkStealingPool;
+
+//
+// Draws 64 sprites at random positions, then hits an invalid opcode.
+//
+static const std::vector<uint8_t> kRandomSpritesRom = {
+    0xC0, 0x3F, // 0x200: V0 = rand & 0x3F
+    0xC1, 0x1F, // 0x202: V1 = rand & 0x1F
+    0xA0, 0x00, // 0x204: I = sprite for 0
+    0xD0, 0x15, // 0x206: draw at V0, V1
+    0x72, 0x01, // 0x208: V2 += 1
+    0x32, 0x40, // 0x20A: skip if V2 == 0x40
+    0x12, 0x00, // 0x20C: jump 0x200
+    0xFF, 0xFF, // 0x20E: invalid
+};
+
+void test_pool_runs_every_task_once() {
+    WorkStealingPool pool(4);
+    for (int round = 0; round < 10; round++) {
+        std::vector<int> counts(1000, 0);
+        pool.ParallelFor(counts.size(), [&](const size_t i) { counts[i]++; });
+        for (const auto count : counts) {
+            assert(count == 1);
+        }
+    }
+    std::cout << "test_pool_runs_every_task_once passed\n";
+}
+
+//
+// Back to back tiny batches on more workers than tasks, so workers routinely wake
+// up late for a batch that's already done while the next one is being published.
+//
+void test_pool_stress_tiny_batches() {
+    WorkStealingPool pool(8);
+    for (int round = 0; round < 5000; round++) {
+        std::vector<int> counts(1 + round % 3, 0);
+        pool.ParallelFor(counts.size(), [&counts, round](const size_t i) {
+            assert(counts.size() == static_cast<size_t>(1 + round % 3));
+            counts[i]++;
+        });
+        for (const auto count : counts) {
+            assert(count == 1);
+        }
+    }
+    std::cout << "test_pool_stress_tiny_batches passed\n";
+}
+
+void test_farm_results_are_deterministic() {
+    std::vector<uint32_t> seeds(64);
+    std::iota(seeds.begin(), seeds.end(), 1);
+
+    Farm single(kRandomSpritesRom, seeds, chip8_emu::CpuCore::kHandlerTable, 10, 1);
+    Farm parallel(kRandomSpritesRom, seeds, chip8_emu::CpuCore::kHandlerTable, 10, 8);
+    const auto& expected = single.Run(100);
+    const auto& actual = parallel.Run(100);
+
+    for (size_t i = 0; i < seeds.size(); i++) {
+        assert(actual[i].exit_reason == ExitReason::kTrapped);
+        assert(actual[i].instructions == 64 * 7);
+        assert(actual[i].framebuffer_hash == expected[i].framebuffer_hash);
+    }
+    assert(actual[0].framebuffer_hash != actual[1].framebuffer_hash);
+    std::cout << "test_farm_results_are_deterministic passed\n";
+}
+
+void test_farm_frame_limit() {
+    Farm farm(kRandomSpritesRom, { 7 }, chip8_emu::CpuCore::kHandlerTable, 10, 2);
+    farm.Run(5);
+    const auto& results = farm.Run(5);
+    assert(results[0].exit_reason == ExitReason::kFrameLimit);
+    assert(results[0].frames == 10);
+    assert(results[0].instructions == 100);
+    std::cout << "test_farm_frame_limit passed\n";
+}
+
+void test_farm_memory_fault() {
+    //
+    // Stores V0-VF at 0xFFF, 15 bytes past the end of memory.
+    //
+    const std::vector<uint8_t> rom = {
+        0xAF, 0xFF, // 0x200: I = 0xFFF
+        0xFF, 0x55, // 0x202: store V0-VF
+        0x12, 0x04, // 0x204: jump 0x204
+    };
+    Farm farm(rom, { 1 }, chip8_emu::CpuCore::kHandlerTable, 10, 1);
+    const auto& results = farm.Run(5);
+#if defined(CHIP8_CHECKED_MEMORY)
+    assert(results[0].exit_reason == ExitReason::kError);
+    assert(results[0].error == "Memory fault: Write of 16 bytes at 0xfff");
+    assert(results[0].frames == 1);
+#else
+    assert(results[0].exit_reason == ExitReason::kFrameLimit);
+    assert(results[0].frames == 5);
+#endif
+    std::cout << "test_farm_memory_fault passed\n";
+}
+
+int main() {
+    try {
+        test_pool_runs_every_task_once();
+        test_pool_stress_tiny_batches();
+        test_farm_results_are_deterministic();
+        test_farm_frame_limit();
+        test_farm_memory_fault();
+        std::cout << "All Farm tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+#include "differential.hpp"
+
+//
+// Differential tests: the JIT must end in exactly the same state as the interpreter.
+//
+
+using chip8_emu::CpuCore;
+
+//
+// The whole budget in a single frame, so blocks run as long as they can.
+//
+static Outcome run(const CpuCore core, const std::vector<uint8_t>& rom, const uint64_t budget) {
+    return run_cpu(core, rom, 1, 1, static_cast<uint32_t>(budget));
+}
+
+static void expect_same(const std::vector<uint8_t>& rom, const uint64_t budget) {
+    expect_same(run(CpuCore::kJit, rom, budget), run(CpuCore::kHandlerTable, rom, budget));
+}
+
+void test_jit_loop() {
+    const std::vector<uint8_t> rom = {
+        0x60, 0x00, 0x61, 0x01, 0x80, 0x14, 0x72, 0x01,
+        0x32, 0x00, 0x12, 0x04, 0x22, 0x10, 0x12, 0x04,
+        0x83, 0x24, 0xA3, 0x00, 0xF3, 0x1E, 0x00, 0xEE,
+    };
+    for (const uint64_t budget : { 1ULL, 3ULL, 5ULL, 1000ULL, 1000003ULL }) {
+        expect_same(rom, budget);
+    }
+    std::cout << "test_jit_loop passed\n";
+}
+
+void test_jit_self_modifying_code() {
+    //
+    // Stores 0x6142 over the instruction at 0x20A, which sets V1 = 0x42 instead of 0x07.
+    //
+    const std::vector<uint8_t> rom = {
+        0x60, 0x61, // 0x200: V0 = 0x61
+        0x61, 0x42, // 0x202: V1 = 0x42
+        0xA2, 0x0A, // 0x204: I = 0x20A
+        0xF1, 0x55, // 0x206: store V0..V1
+        0x12, 0x0A, // 0x208: jump 0x20A
+        0x61, 0x07, // 0x20A: V1 = 0x07, overwritten
+        0x12, 0x00, // 0x20C: jump 0x200
+    };
+    for (const uint64_t budget : { 6ULL, 7ULL, 100ULL }) {
+        expect_same(rom, budget);
+    }
+    assert(run(CpuCore::kJit, rom, 6).registers.v[1] == 0x42);
+    std::cout << "test_jit_self_modifying_code passed\n";
+}
+
+void test_jit_random_programs() {
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 500; i++) {
+        const auto rom = random_rom(rng, 8 + rng() % 120, OpcodeMix::kCore);
+        expect_same(rom, 1 + rng() % 50000);
+    }
+    std::cout << "test_jit_random_programs passed\n";
+}
+
+int main() {
+#if defined(CHIP8_HAS_JIT)
+    try {
+        test_jit_loop();
+        test_jit_self_modifying_code();
+        test_jit_random_programs();
+        std::cout << "All JIT tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+#else
+    std::cout << "JIT not available on this platform, skipping\n";
+#endif
+    return 0;
+}
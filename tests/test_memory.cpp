@@ -0,0 +1,156 @@
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+
+using chip8_emu::CheckedAccess;
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+using chip8_emu::Memory;
+using chip8_emu::WrappedAccess;
+
+void test_wrapped_memory_wraps_around() {
+    Memory<WrappedAccess> memory;
+
+    memory.Write(0xAB, 0x1005);
+    assert(memory.Read(0x005) == 0xAB);
+
+    const uint8_t bytes[] = { 1, 2, 3, 4 };
+    memory.Write(bytes, sizeof(bytes), 0xFFE);
+    assert(memory.Read(0xFFF) == 2);
+    assert(memory.Read(0x000) == 3);
+    assert(memory.Read(0x001) == 4);
+
+    uint8_t read[4] = {};
+    memory.Read(0xFFE, read, sizeof(read));
+    assert(read[0] == 1 && read[3] == 4);
+
+    const auto view = memory.View(0xFFF, 2);
+    assert(view[0] == 2 && view[1] == 3);
+
+    uint16_t pc = 0xFFF;
+    const auto opcode = memory.FetchOpcode(pc);
+    assert(opcode.first_byte == 2 && opcode.second_byte == 3);
+    assert(pc == 0x1001);
+    assert(!memory.HasFault());
+    std::cout << "test_wrapped_memory_wraps_around passed\n";
+}
+
+void test_checked_memory_records_faults() {
+    Memory<CheckedAccess> memory;
+
+    const uint8_t bytes[] = { 1, 2, 3 };
+    memory.Write(bytes, sizeof(bytes), 0xFFD);
+    assert(!memory.HasFault());
+
+    //
+    // Out of bounds writes are dropped, reads see zeros, only the first fault is kept.
+    //
+    memory.Write(bytes, sizeof(bytes), 0xFFE);
+    assert(memory.HasFault());
+    assert(memory.GetFault().address == 0xFFE);
+    assert(memory.GetFault().size == 3);
+    assert(memory.GetFault().is_write);
+    assert(memory.Read(0xFFE) == 2);
+    assert(memory.Read(0x000) == 0xF0);
+
+    assert(memory.Read(0x1000) == 0);
+    assert(memory.GetFault().address == 0xFFE);
+
+    memory.ClearFault();
+    uint16_t pc = 0xFFF;
+    memory.FetchOpcode(pc);
+    assert(memory.HasFault());
+    assert(!memory.GetFault().is_write);
+    assert(memory.GetFault().address == 0xFFF);
+    std::cout << "test_checked_memory_records_faults passed\n";
+}
+
+void test_register_blocks_only_touch_count_bytes() {
+    uint8_t v[16];
+    for (uint8_t i = 0; i < 16; i++) {
+        v[i] = static_cast<uint8_t>(0xA0 + i);
+    }
+
+    for (const uint16_t address : { 0x300, 0xFF0, 0xFF8, 0xFFF }) {
+        for (uint8_t count = 1; count <= 16; count++) {
+            Memory<WrappedAccess> memory;
+            for (uint16_t i = 0; i < 32; i++) {
+                memory.Write(0x55, static_cast<uint16_t>(address - 8 + i));
+            }
+
+            memory.StoreRegisters(v, count, address);
+            for (uint16_t i = 0; i < 24; i++) {
+                const auto expected = i < count ? v[i] : 0x55;
+                assert(memory.Read(static_cast<uint16_t>(address + i)) == expected);
+            }
+            assert(memory.Read(static_cast<uint16_t>(address - 1)) == 0x55);
+
+            uint8_t loaded[16];
+            std::fill(std::begin(loaded), std::end(loaded), 0x11);
+            memory.LoadRegisters(address, loaded, count);
+            for (uint8_t i = 0; i < 16; i++) {
+                assert(loaded[i] == (i < count ? v[i] : 0x11));
+            }
+        }
+    }
+    std::cout << "test_register_blocks_only_touch_count_bytes passed\n";
+}
+
+void test_register_transfers_wrap() {
+    const std::vector<uint8_t> rom = {
+        0x60, 0x12, // 0x200: V0 = 0x12
+        0x61, 0x34, // 0x202: V1 = 0x34
+        0x62, 0xFF, // 0x204: V2 = 255
+        0xAF, 0xFF, // 0x206: I = 0xFFF
+        0xF2, 0x55, // 0x208: store V0-V2 at I, wrapping to 0x000
+        0xF2, 0x33, // 0x20A: BCD of V2 at I
+        0x60, 0x00, // 0x20C: V0 = 0
+        0x61, 0x00, // 0x20E: V1 = 0
+        0xF1, 0x65, // 0x210: V0-V1 = memory at I
+    };
+
+    //
+    // Only Cpu's default policy wraps, checked builds stop at the first store instead.
+    //
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+        Cpu<> cpu(core, Frontend::kHeadless);
+        cpu.Load(rom);
+        const auto executed = cpu.Execute(rom.size() / 2);
+
+        const auto& registers = cpu.GetRegisters();
+        assert(!cpu.IsTrapped());
+#if defined(CHIP8_CHECKED_MEMORY)
+        assert(executed == 5);
+        assert(registers.pc == 0x20A);
+        assert(cpu.GetMemory().HasFault());
+        assert(cpu.Execute(10) == 0);
+        assert(cpu.GetMemory().GetFault().ToString() == "Write of 3 bytes at 0xfff");
+#else
+        assert(executed == rom.size() / 2);
+        assert(registers.v[0] == 2);
+        assert(registers.v[1] == 5);
+        assert(registers.pc == 0x200 + rom.size());
+#endif
+    }
+    std::cout << "test_register_transfers_wrap passed\n";
+}
+
+int main() {
+    try {
+        test_wrapped_memory_wraps_around();
+        test_checked_memory_records_faults();
+        test_register_blocks_only_touch_count_bytes();
+        test_register_transfers_wrap();
+        std::cout << "All Memory tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
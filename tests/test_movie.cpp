@@ -0,0 +1,88 @@
+#include <iostream>
+#include <cassert>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+#include "movie.hpp"
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+//
+// Waits for a key, draws it at a random position and counts frames while it's held.
+//
+static const std::vector<uint8_t> kKeysRom = {
+    0xF0, 0x0A, // 0x200: V0 = wait for key
+    0xF0, 0x29, // 0x202: I = sprite for V0
+    0xC1, 0x3F, // 0x204: V1 = rand & 0x3F
+    0xC2, 0x1F, // 0x206: V2 = rand & 0x1F
+    0xD1, 0x25, // 0x208: draw at V1, V2
+    0xE0, 0x9E, // 0x20A: skip if key V0 is pressed
+    0x12, 0x00, // 0x20C: jump 0x200
+    0x73, 0x01, // 0x20E: V3 += 1
+    0x12, 0x0A, // 0x210: jump 0x20A
+};
+
+//
+// Keys held for random stretches of frames, some longer than a movie run.
+//
+static std::vector<uint16_t> random_keys(const size_t frames) {
+    std::mt19937 rng(99);
+    std::vector<uint16_t> keys;
+    while (keys.size() < frames) {
+        const uint16_t held = (rng() % 3 == 0) ? 0 : static_cast<uint16_t>(rng());
+        keys.insert(keys.end(), 1 + rng() % 150, held);
+    }
+    keys.resize(frames);
+    return keys;
+}
+
+void test_movie_replay_is_identical() {
+    const auto path = (std::filesystem::temp_directory_path() / "test_movie.c8mv").string();
+    const auto keys = random_keys(3000);
+
+    Cpu<> recorded(CpuCore::kHandlerTable, Frontend::kHeadless);
+    recorded.Load(kKeysRom);
+    recorded.Seed(1234);
+    {
+        chip8_emu::MovieRecorder recorder(path, chip8_emu::HashRom(kKeysRom), recorded.GetSeed(), 9);
+        for (const auto held : keys) {
+            recorded.SetKeys(held);
+            recorder.Record(recorded.GetKeys());
+            recorded.RunFrame(9);
+        }
+    }
+    assert(recorded.GetRegisters().v[3] != 0);
+
+    const auto movie = chip8_emu::LoadMovie(path);
+    assert(movie.keys == keys);
+    assert(movie.seed == 1234);
+    assert(movie.instructions_per_frame == 9);
+    assert(movie.rom_hash == chip8_emu::HashRom(kKeysRom));
+    assert(std::filesystem::file_size(path) < keys.size());
+
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+        Cpu<> replayed(core, Frontend::kHeadless);
+        replayed.Load(kKeysRom);
+        assert(chip8_emu::ReplayMovie(replayed, movie) == keys.size());
+        assert(replayed.GetFramebuffer().Hash() == recorded.GetFramebuffer().Hash());
+        assert(replayed.SaveState() == recorded.SaveState());
+    }
+
+    std::filesystem::remove(path);
+    std::cout << "test_movie_replay_is_identical passed\n";
+}
+
+int main() {
+    try {
+        test_movie_replay_is_identical();
+        std::cout << "All Movie tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+#include "rewind.hpp"
+#include "roms.hpp"
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+using chip8_emu::RewindBuffer;
+
+void test_rewind_restores_every_kept_frame() {
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(kBusyRom);
+
+    RewindBuffer rewind(300, 60);
+    std::vector<std::vector<uint8_t>> states;
+    for (int frame = 0; frame < 1000; frame++) {
+        cpu.RunFrame(7);
+        states.push_back(cpu.SaveState());
+        rewind.Push(states.back());
+    }
+
+    assert(rewind.GetFrameCount() >= 300);
+    assert(rewind.GetMemoryUsage() < states.size() * states[0].size() / 4);
+    for (size_t i = 0; i < rewind.GetFrameCount(); i++) {
+        assert(rewind.GetState(i) == states[states.size() - 1 - i]);
+    }
+
+    bool threw = false;
+    try {
+        rewind.GetState(rewind.GetFrameCount());
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "test_rewind_restores_every_kept_frame passed\n";
+}
+
+void test_rewind_then_continue() {
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(kBusyRom);
+
+    RewindBuffer rewind(100, 16);
+    std::vector<std::vector<uint8_t>> states;
+    for (int frame = 0; frame < 150; frame++) {
+        cpu.RunFrame(7);
+        states.push_back(cpu.SaveState());
+        rewind.Push(states.back());
+    }
+
+    //
+    // Going back 37 frames and playing them again must record the same history.
+    //
+    cpu.LoadState(rewind.Rewind(37));
+    states.resize(states.size() - 37);
+    assert(cpu.SaveState() == states.back());
+
+    for (int frame = 0; frame < 200; frame++) {
+        cpu.RunFrame(7);
+        states.push_back(cpu.SaveState());
+        rewind.Push(states.back());
+    }
+
+    assert(rewind.GetFrameCount() >= 100);
+    for (size_t i = 0; i < rewind.GetFrameCount(); i++) {
+        assert(rewind.GetState(i) == states[states.size() - 1 - i]);
+    }
+    std::cout << "test_rewind_then_continue passed\n";
+}
+
+int main() {
+    try {
+        test_rewind_restores_every_kept_frame();
+        test_rewind_then_continue();
+        std::cout << "All Rewind tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+#include "roms.hpp"
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+
+static void run_frames(Cpu<>& cpu, const int frames) {
+    for (int i = 0; i < frames; i++) {
+        cpu.RunFrame(7);
+    }
+}
+
+void test_savestate_round_trip() {
+    Cpu<> original(CpuCore::kHandlerTable, Frontend::kHeadless);
+    original.Load(kBusyRom);
+    original.Seed(5);
+    run_frames(original, 13);
+    const auto state = original.SaveState();
+    run_frames(original, 50);
+
+    //
+    // Warm up another core on a different program first, nothing of it may survive the load.
+    //
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+        Cpu<> restored(core, Frontend::kHeadless);
+        restored.Load({ 0x70, 0x01, 0x12, 0x00 });
+        run_frames(restored, 3);
+
+        restored.LoadState(state);
+        assert(restored.SaveState() == state);
+        run_frames(restored, 50);
+
+        assert(restored.SaveState() == original.SaveState());
+        assert(restored.GetFramebuffer().Hash() == original.GetFramebuffer().Hash());
+    }
+    std::cout << "test_savestate_round_trip passed\n";
+}
+
+void test_savestate_rejects_invalid() {
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(kBusyRom);
+    run_frames(cpu, 3);
+    const auto state = cpu.SaveState();
+
+    auto bad_magic = state;
+    bad_magic[0] = 'X';
+
+    auto bad_version = state;
+    bad_version[4]++;
+
+    auto truncated = state;
+    truncated.pop_back();
+
+    auto bad_stack_pointer = state;
+    bad_stack_pointer[6] = chip8_emu::kStackSize + 1;
+
+    for (const auto& invalid : { bad_magic, bad_version, truncated, bad_stack_pointer, std::vector<uint8_t>{} }) {
+        bool threw = false;
+        try {
+            cpu.LoadState(invalid);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        assert(cpu.SaveState() == state);
+    }
+    std::cout << "test_savestate_rejects_invalid passed\n";
+}
+
+int main() {
+    try {
+        test_savestate_round_trip();
+        test_savestate_rejects_invalid();
+        std::cout << "All Savestate tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
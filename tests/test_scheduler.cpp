@@ -0,0 +1,159 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "cpu.hpp"
+
+using chip8_emu::Cpu;
+using chip8_emu::CpuCore;
+using chip8_emu::Frontend;
+using chip8_emu::FramePacer;
+
+static const std::vector<uint8_t> kTimerRom = {
+    0x60, 0x1E, // 0x200: V0 = 30
+    0xF0, 0x15, // 0x202: DT = V0
+    0xF1, 0x07, // 0x204: V1 = DT
+    0x72, 0x01, // 0x206: V2 += 1
+    0x12, 0x04, // 0x208: jump 0x204
+};
+
+void test_scheduler_ticks_timers_per_frame() {
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(kTimerRom);
+    for (int i = 0; i < 10; i++) {
+        cpu.RunFrame(10);
+    }
+    assert(cpu.GetRegisters().delay_timer == 20);
+    std::cout << "test_scheduler_ticks_timers_per_frame passed\n";
+}
+
+void test_scheduler_is_deterministic() {
+    Cpu<> first(CpuCore::kHandlerTable, Frontend::kHeadless);
+    Cpu<> second(CpuCore::kHandlerTable, Frontend::kHeadless);
+    first.Load(kTimerRom);
+    second.Load(kTimerRom);
+    for (int i = 0; i < 100; i++) {
+        first.RunFrame(7);
+        second.RunFrame(7);
+    }
+    const auto& a = first.GetRegisters();
+    const auto& b = second.GetRegisters();
+    assert(std::memcmp(&a, &b, sizeof(a)) == 0);
+    assert(a.delay_timer == 0);
+    std::cout << "test_scheduler_is_deterministic passed\n";
+}
+
+void test_wait_for_key_halts_until_pressed() {
+    const std::vector<uint8_t> rom = {
+        0x60, 0x05, // 0x200: V0 = 5
+        0xF0, 0x15, // 0x202: DT = V0
+        0xF3, 0x0A, // 0x204: V3 = wait for key
+        0x74, 0x01, // 0x206: V4 += 1
+        0x12, 0x06, // 0x208: jump 0x206
+    };
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+        Cpu<> cpu(core, Frontend::kHeadless);
+        cpu.Load(rom);
+
+        //
+        // Nothing executes past FX0A, but the timer keeps running down.
+        //
+        assert(cpu.RunFrame(100) == 3);
+        assert(cpu.IsWaitingForKey() && !cpu.IsParked());
+        for (int i = 0; i < 4; i++) {
+            assert(cpu.RunFrame(100) == 0);
+        }
+        assert(cpu.IsParked());
+        assert(cpu.GetRegisters().v[4] == 0);
+
+        cpu.SetKeys(1 << 0xB);
+        assert(!cpu.IsWaitingForKey());
+        assert(cpu.GetRegisters().v[3] == 0xB);
+        assert(cpu.RunFrame(10) == 10);
+        assert(cpu.GetRegisters().v[4] == 5);
+    }
+    std::cout << "test_wait_for_key_halts_until_pressed passed\n";
+}
+
+void test_idle_loops_are_skipped_exactly() {
+    //
+    // Waits for the delay timer, then for key 5 to be pressed and released.
+    //
+    const std::vector<uint8_t> rom = {
+        0x60, 0x05, // 0x200: V0 = 5
+        0xF0, 0x15, // 0x202: DT = V0
+        0x71, 0x01, // 0x204: V1 += 1
+        0xF2, 0x07, // 0x206: V2 = DT
+        0x32, 0x00, // 0x208: skip if V2 == 0
+        0x12, 0x06, // 0x20A: jump 0x206
+        0x61, 0x05, // 0x20C: V1 = 5
+        0xE1, 0xA1, // 0x20E: skip if key V1 not pressed
+        0x12, 0x14, // 0x210: jump 0x214
+        0x12, 0x0E, // 0x212: jump 0x20E
+        0x73, 0x01, // 0x214: V3 += 1
+        0xE1, 0x9E, // 0x216: skip if key V1 pressed
+        0x12, 0x00, // 0x218: jump 0x200
+        0x12, 0x16, // 0x21A: jump 0x216
+    };
+    for (const auto core : { CpuCore::kHandlerTable, CpuCore::kThreaded, CpuCore::kJit }) {
+        for (const uint32_t instructions_per_frame : { 1u, 7u, 100u, 1001u }) {
+            Cpu<> expected(CpuCore::kHandlerTable, Frontend::kHeadless);
+            expected.SetIdleLoopSkipping(false);
+            expected.Load(rom);
+
+            Cpu<> actual(core, Frontend::kHeadless);
+            actual.Load(rom);
+
+            for (int frame = 0; frame < 200; frame++) {
+                const uint16_t keys = frame % 30 < 10 ? 1 << 5 : 0;
+                expected.SetKeys(keys);
+                actual.SetKeys(keys);
+
+                assert(actual.RunFrame(instructions_per_frame) == expected.RunFrame(instructions_per_frame));
+                assert(std::memcmp(&actual.GetRegisters(), &expected.GetRegisters(), sizeof(chip8_emu::Registers)) == 0);
+            }
+            assert(expected.GetRegisters().v[3] > 0);
+        }
+    }
+
+    //
+    // Only whole iterations are skipped, a budget no one could interpret
+    // ends where interpreting it would.
+    //
+    Cpu<> cpu(CpuCore::kHandlerTable, Frontend::kHeadless);
+    cpu.Load(rom);
+    const uint64_t budget = 1000000000001;
+    assert(cpu.Execute(budget) == budget);
+    assert(cpu.GetRegisters().pc == 0x206 + 2 * ((budget - 3) % 3));
+    std::cout << "test_idle_loops_are_skipped_exactly passed\n";
+}
+
+void test_frame_pacer_waits_for_deadlines() {
+    //
+    // Capture start first, the pacer's deadlines are relative to its construction.
+    //
+    const auto start = std::chrono::steady_clock::now();
+    FramePacer pacer{ 60 };
+    for (int i = 0; i < 6; i++) {
+        pacer.WaitForNextFrame();
+    }
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100));
+    std::cout << "test_frame_pacer_waits_for_deadlines passed\n";
+}
+
+int main() {
+    try {
+        test_scheduler_ticks_timers_per_frame();
+        test_scheduler_is_deterministic();
+        test_wait_for_key_halts_until_pressed();
+        test_idle_loops_are_skipped_exactly();
+        test_frame_pacer_waits_for_deadlines();
+        std::cout << "All Scheduler tests passed!\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Test failed with exception: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "aot_emitter.hpp"
+#include "cfg.hpp"
+
+//
+// Compiles a ROM ahead of time to C++, see AotEmitter.
+// Usage: chip8-aot rom_file output.cpp
+// Build the output with the emulator headers, it has its own main, see
+// RunCompiledProgram. Everything runs through the interpreter once the ROM
+// modifies its own compiled code.
+//
+
+using chip8_emu::AotEmitter;
+using chip8_emu::ControlFlowGraph;
+
+static std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io)
+    {
+        throw std::runtime_error{ std::format("Could not open {}", path) };
+    }
+
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(size);
+    io.read((char*)bytes.data(), size);
+
+    return bytes;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: chip8-aot rom_file output.cpp\n";
+        return 1;
+    }
+
+    try
+    {
+        const ControlFlowGraph cfg(ReadFile(argv[1]));
+        if (cfg.GetBlocks().empty())
+        {
+            throw std::runtime_error{ std::format("No code found in {}", argv[1]) };
+        }
+
+        std::ofstream out(argv[2]);
+        AotEmitter::EmitProgram(cfg, argv[1], out);
+        AotEmitter::EmitMain(out);
+        if (!out)
+        {
+            throw std::runtime_error{ std::format("Could not write {}", argv[2]) };
+        }
+
+        std::cout << std::format("Compiled {} blocks{}\n", cfg.GetBlocks().size(),
+            cfg.HasComputedJumps() ? ", computed jumps will be interpreted" : "");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unexpected error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cfg.hpp"
+
+//
+// Disassembles a ROM along its recovered control flow graph.
+// Usage: chip8-disasm [--dot] rom_file
+// Prints an annotated listing, or the graph in Graphviz format with --dot.
+//
+
+using chip8_emu::BasicBlock;
+using chip8_emu::BlockExit;
+using chip8_emu::ControlFlowGraph;
+using chip8_emu::Decoder;
+
+static std::vector<uint8_t> ReadFile(const std::string& path)
+{
+    std::ifstream io(path, std::ios::binary | std::ios::ate);
+    if (!io)
+    {
+        throw std::runtime_error{ std::format("Could not open {}", path) };
+    }
+
+    const auto size = io.tellg();
+    io.seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(size);
+    io.read((char*)bytes.data(), size);
+
+    return bytes;
+}
+
+static std::string DescribeExit(const BasicBlock& block)
+{
+    switch (block.exit)
+    {
+    case BlockExit::kCall:
+        return std::format("calls {:#05x}", block.target);
+    case BlockExit::kReturn:
+        return "returns";
+    case BlockExit::kComputedJump:
+        return std::format("computed jump from {:#05x}, targets unknown", block.target);
+    case BlockExit::kStop:
+        return "stops";
+    default:
+        return "";
+    }
+}
+
+static void PrintListing(const ControlFlowGraph& cfg, std::ostream& out)
+{
+    out << std::format("; {} bytes at {:#05x}, {} blocks, {} functions\n",
+        cfg.GetRom().size(), cfg.GetBase(), cfg.GetBlocks().size(), cfg.GetFunctions().size());
+
+    auto data = cfg.GetDataRegions().begin();
+    const auto print_data_before = [&](const uint32_t address)
+    {
+        for (; data != cfg.GetDataRegions().end() && data->start < address; ++data)
+        {
+            out << std::format("\n; data {:#05x}-{:#05x}{}\n", data->start, data->end - 1, data->is_referenced ? ", loaded into I" : "");
+            for (uint32_t row = data->start; row < data->end; row += 8)
+            {
+                out << std::format("  {:#05x}  DB", row);
+                for (uint32_t i = row; i < std::min<uint32_t>(row + 8, data->end); i++)
+                {
+                    out << std::format(" {:#04x}", cfg.GetRom()[i - cfg.GetBase()]);
+                }
+                out << "\n";
+            }
+        }
+    };
+
+    for (const auto& [start, block] : cfg.GetBlocks())
+    {
+        print_data_before(start);
+
+        if (cfg.GetFunctions().contains(start))
+        {
+            out << std::format("\nsub_{:03x}:\n", start);
+        }
+
+        std::string successors;
+        for (const auto successor : block.successors)
+        {
+            successors += std::format(" {:#05x}", successor);
+        }
+        out << std::format("L_{:03x}:{}\n", start, successors.empty() ? "" : " ; ->" + successors);
+
+        for (uint16_t pc = block.start; pc < block.end; pc += 2)
+        {
+            const auto opcode = cfg.GetOpcode(pc);
+            out << std::format("  {:#05x}  {:04X}  {}\n", pc, opcode.Value(), Decoder::Disassemble(opcode));
+        }
+
+        const auto exit = DescribeExit(block);
+        if (!exit.empty())
+        {
+            out << "  ; " << exit << "\n";
+        }
+    }
+
+    print_data_before(UINT32_MAX);
+}
+
+static void PrintDot(const ControlFlowGraph& cfg, std::ostream& out)
+{
+    out << "digraph cfg {\n";
+    out << "    node [shape=box, fontname=\"monospace\"];\n";
+
+    for (const auto& [start, block] : cfg.GetBlocks())
+    {
+        std::string label = std::format("{}{:#05x}\\l", cfg.GetFunctions().contains(start) ? "sub " : "", start);
+        for (uint16_t pc = block.start; pc < block.end; pc += 2)
+        {
+            label += Decoder::Disassemble(cfg.GetOpcode(pc)) + "\\l";
+        }
+
+        out << std::format("    b{:03x} [label=\"{}\"{}];\n", start, label, block.exit == BlockExit::kComputedJump ? ", color=red" : "");
+
+        for (const auto successor : block.successors)
+        {
+            out << std::format("    b{:03x} -> b{:03x};\n", start, successor);
+        }
+
+        if (block.exit == BlockExit::kCall && cfg.FindBlock(block.target) != nullptr)
+        {
+            out << std::format("    b{:03x} -> b{:03x} [style=dashed, label=\"call\"];\n", start, block.target);
+        }
+    }
+
+    out << "}\n";
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        bool is_dot = false;
+        std::string rom_path;
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--dot") == 0)
+            {
+                is_dot = true;
+            }
+            else
+            {
+                rom_path = argv[i];
+            }
+        }
+
+        if (rom_path.empty())
+        {
+            std::cerr << "Usage: chip8-disasm [--dot] rom_file\n";
+            return 1;
+        }
+
+        const ControlFlowGraph cfg(ReadFile(rom_path));
+        if (is_dot)
+        {
+            PrintDot(cfg, std::cout);
+        }
+        else
+        {
+            PrintListing(cfg, std::cout);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Unexpected error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}